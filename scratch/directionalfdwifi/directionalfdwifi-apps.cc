@@ -168,6 +168,8 @@ FdReceiver::GetTypeId (void)
                    MakeUintegerChecker<uint32_t>(0))
     .AddTraceSource ("Rx", "Receive data packet",
                      MakeTraceSourceAccessor (&FdReceiver::m_rxTrace))
+    .AddTraceSource ("Delay", "End-to-end delay of a received data packet",
+                     MakeTraceSourceAccessor (&FdReceiver::m_delayTrace))
   ;
   return tid;
 }
@@ -261,6 +263,7 @@ FdReceiver::Receive (Ptr<Socket> socket)
       if (m_delay != 0) {
 	m_delay->Update (Simulator::Now () - tx);
       }
+      m_delayTrace (Simulator::Now () - tx);
       /* [add] 20140618 sugiyama */
       m_rxTrace (++m_count, m_numPkts);
       /* [end]*/
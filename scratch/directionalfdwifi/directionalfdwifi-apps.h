@@ -95,6 +95,7 @@ private:
   Ptr<CounterCalculator<> > m_calc;
   Ptr<TimeMinMaxAvgTotalCalculator> m_delay;
   TracedCallback<uint32_t, uint32_t > m_rxTrace;
+  TracedCallback<Time> m_delayTrace;
   // end class FdReceiver
 };
 
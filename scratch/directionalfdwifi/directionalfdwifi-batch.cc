@@ -0,0 +1,214 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ns3/core-module.h"
+
+#include "directionalfdwifi-batch.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("FdWifiBatch");
+
+FdScenario::FdScenario ()
+  : nodeAmount (3),
+    distance (90),
+    rate (0.002),
+    run (1)
+{
+}
+
+FdBatchRunner::FdBatchRunner ()
+  : m_jobs (0),
+    m_prefix ("data")
+{
+}
+
+bool
+FdBatchRunner::ReadGrid (std::string fileName, uint32_t runBase)
+{
+  std::ifstream grid (fileName.c_str ());
+  if (!grid.is_open ()) {
+    NS_LOG_ERROR ("Cannot open grid file " << fileName);
+    return false;
+  }
+
+  std::string line;
+  uint32_t lineNumber = 0;
+  while (std::getline (grid, line)) {
+    lineNumber++;
+    std::string::size_type comment = line.find ('#');
+    if (comment != std::string::npos) {
+      line.erase (comment);
+    }
+    std::istringstream fields (line);
+    std::string first;
+    if (!(fields >> first)) {
+      continue;
+    }
+
+    fields.clear ();
+    fields.seekg (0);
+    FdScenario scenario;
+    if (!(fields >> scenario.nodeAmount >> scenario.distance >> scenario.rate)) {
+      NS_LOG_ERROR (fileName << ":" << lineNumber << ": expected \"nodeAmount distance rate [run]\"");
+      return false;
+    }
+    uint32_t run;
+    if (fields >> run) {
+      scenario.run = run;
+    } else {
+      scenario.run = runBase + m_scenarios.size ();
+    }
+
+    std::ostringstream runId;
+    runId << "run-" << scenario.run;
+    scenario.runId = runId.str ();
+    m_scenarios.push_back (scenario);
+  }
+  return true;
+}
+
+uint32_t
+FdBatchRunner::GetNScenarios (void) const
+{
+  return m_scenarios.size ();
+}
+
+void
+FdBatchRunner::SetJobs (uint32_t jobs)
+{
+  m_jobs = jobs;
+}
+
+void
+FdBatchRunner::SetFilePrefix (std::string prefix)
+{
+  m_prefix = prefix;
+}
+
+std::string
+FdBatchRunner::GetMergedFileName (void) const
+{
+  return m_prefix + "-batch.sca";
+}
+
+std::string
+FdBatchRunner::GetPointPrefix (uint32_t i) const
+{
+  std::ostringstream prefix;
+  prefix << m_prefix << "-point" << i;
+  return prefix.str ();
+}
+
+std::string
+FdBatchRunner::GetPointFileName (uint32_t i) const
+{
+  // the name OmnetDataOutput gives to its scalar file
+  return GetPointPrefix (i) + "-" + m_scenarios[i].runId + ".sca";
+}
+
+uint32_t
+FdBatchRunner::Run (ScenarioCallback scenario)
+{
+  uint32_t jobs = m_jobs;
+  if (jobs == 0) {
+    long processors = sysconf (_SC_NPROCESSORS_ONLN);
+    jobs = processors > 0 ? processors : 1;
+  }
+  NS_LOG_INFO ("Running " << m_scenarios.size () << " points on " << jobs << " workers.");
+
+  std::vector<bool> ok (m_scenarios.size (), false);
+  std::map<pid_t, uint32_t> running;
+  uint32_t next = 0;
+  while (next < m_scenarios.size () || !running.empty ()) {
+    while (next < m_scenarios.size () && running.size () < jobs) {
+      // the child must not write out what the driver has buffered
+      std::cout.flush ();
+      std::cerr.flush ();
+      pid_t pid = fork ();
+      if (pid == 0) {
+        RngSeedManager::SetRun (m_scenarios[next].run);
+        int status = scenario (m_scenarios[next], GetPointPrefix (next));
+        std::cout.flush ();
+        _exit (status == 0 ? 0 : 1);
+      }
+      if (pid < 0) {
+        NS_LOG_ERROR ("Cannot start a worker for point " << next);
+        if (running.empty ()) {
+          next++;
+          continue;
+        }
+        break;
+      }
+      running[pid] = next;
+      next++;
+    }
+
+    if (running.empty ()) {
+      continue;
+    }
+    int status;
+    pid_t pid = wait (&status);
+    if (pid < 0) {
+      NS_LOG_ERROR ("Lost track of the workers");
+      break;
+    }
+    std::map<pid_t, uint32_t>::iterator i = running.find (pid);
+    if (i == running.end ()) {
+      continue;
+    }
+    ok[i->second] = WIFEXITED (status) && WEXITSTATUS (status) == 0;
+    NS_LOG_INFO ("Point " << i->second << " (" << m_scenarios[i->second].runId << ") "
+                 << (ok[i->second] ? "done" : "failed"));
+    running.erase (i);
+  }
+
+  return Merge (ok);
+}
+
+uint32_t
+FdBatchRunner::Merge (std::vector<bool> &ok) const
+{
+  std::string mergedName = GetMergedFileName ();
+  std::ofstream merged (mergedName.c_str ());
+  uint32_t failed = 0;
+  for (uint32_t i = 0; i < m_scenarios.size (); i++) {
+    std::string pointName = GetPointFileName (i);
+    std::ifstream point (pointName.c_str ());
+    if (ok[i] && point.is_open ()) {
+      merged << point.rdbuf ();
+    } else {
+      NS_LOG_ERROR ("No result for point " << i << " (" << m_scenarios[i].runId << ")");
+      ok[i] = false;
+      failed++;
+    }
+    if (point.is_open ()) {
+      point.close ();
+      std::remove (pointName.c_str ());
+    }
+  }
+  return failed;
+}
@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Runs the points of a parameter grid in a pool of worker processes.
+ * ns-3 has a single simulator per process, so every point is run in a
+ * child forked from the driver; the per-point omnet outputs are merged
+ * into one file at the end.
+ */
+#ifndef DIRECTIONALFDWIFI_BATCH_H
+#define DIRECTIONALFDWIFI_BATCH_H
+
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+//------------------------------------------------------
+struct FdScenario {
+  FdScenario ();
+
+  uint32_t    nodeAmount;
+  double      distance;
+  double      rate;
+  uint32_t    run;     // RNG run number
+  std::string runId;   // run label of the DataCollector
+};
+
+
+//------------------------------------------------------
+class FdBatchRunner {
+public:
+  /**
+   * Runs one point: the scenario and the file prefix of its output.
+   * Returns 0 on success.
+   */
+  typedef Callback<int, FdScenario, std::string> ScenarioCallback;
+
+  FdBatchRunner ();
+
+  /**
+   * Reads a grid file. Each line holds "nodeAmount distance rate [run]";
+   * '#' starts a comment. Points without a run number get runBase plus
+   * their index in the grid, so that a sweep is reproducible.
+   */
+  bool ReadGrid (std::string fileName, uint32_t runBase);
+  uint32_t GetNScenarios (void) const;
+
+  // number of worker processes; 0 means one per online processor
+  void SetJobs (uint32_t jobs);
+  void SetFilePrefix (std::string prefix);
+  // the file all the per-point results are merged into
+  std::string GetMergedFileName (void) const;
+
+  /**
+   * Runs every point and merges the outputs in grid order.
+   * Returns the number of points which failed.
+   */
+  uint32_t Run (ScenarioCallback scenario);
+
+private:
+  std::string GetPointPrefix (uint32_t i) const;
+  std::string GetPointFileName (uint32_t i) const;
+  uint32_t Merge (std::vector<bool> &ok) const;
+
+  std::vector<FdScenario> m_scenarios;
+  uint32_t    m_jobs;
+  std::string m_prefix;
+
+  // end class FdBatchRunner
+};
+
+#endif /* DIRECTIONALFDWIFI_BATCH_H */
@@ -39,6 +39,8 @@
 #include "ns3/netanim-module.h"
 
 #include "directionalfdwifi-apps.h"
+#include "directionalfdwifi-batch.h"
+#include "directionalfdwifi-results.h"
 
 #define PRIMARY    0
 #define SECONDARY  1
@@ -46,6 +48,7 @@
 #define ACK        3
 #define OTHER      4
 
+static const char *txTypes[5] = {"primary", "secondary", "busytone", "ack", "other"};
 
 #define MAX_TIME 1000
 
@@ -56,6 +59,8 @@ using namespace std;
 NS_LOG_COMPONENT_DEFINE ("FdWifiSimulator");
 
 Time startAnalysisTime = Seconds (0);
+// PHYs counting frames by themselves, reset when the analysis starts
+std::vector<Ptr<YansWifiPhy> > statsPhys;
 
 /**********************************************************
                    Trace data
@@ -68,6 +73,9 @@ AppSenderRx (Ptr<TimeMinMaxAvgTotalCalculator> endTime, std::string path,
   if(!numPkts == 0){
     if(100 == count ){
       startAnalysisTime = Simulator::Now();
+      for (uint32_t i = 0; i < statsPhys.size (); i++) {
+        statsPhys[i]->ResetFrameStats ();
+      }
     }
 
     if(count >= numPkts){
@@ -89,11 +97,32 @@ MacMissedAckCallback (Ptr<CounterCalculator<uint32_t> > datac,
 }
 
 
+// returns the type of a transmitted frame, -1 if it is not counted
+int
+ClassifyTxFrame (Ptr<const Packet> packet, const FdTxMetadata &metadata)
+{
+  WifiMacHeader hdr;
+  packet->PeekHeader (hdr);
+  // every data subtype, QoS data and A-MSDUs included; the null
+  // frames carry no payload and fall below the size limit
+  if(hdr.IsData ()){
+    if (packet->GetSize () <= 100) {return OTHER;}
+    else if(metadata.secondary)     {return SECONDARY;}
+    else                            {return PRIMARY;}
+  }else if(hdr.GetType() == WIFI_MAC_CTL_ACK){
+    return ACK;
+  }else if(hdr.GetType() == WIFI_MAC_CTL_BUSY){
+    return BUSYTONE;
+  }
+  return -1;
+}
+
 void
 PhyTxBeginCallback (Ptr<TimeMinMaxAvgTotalCalculator> endTime,
 		    Ptr<CounterCalculator<uint32_t> > datac[5],
 		    std::string path,
-		    Ptr<const Packet> packet)
+		    Ptr<const Packet> packet,
+		    const FdTxMetadata &metadata)
 {
 
   if(Simulator::Now() >= Seconds(MAX_TIME)){
@@ -101,27 +130,72 @@ PhyTxBeginCallback (Ptr<TimeMinMaxAvgTotalCalculator> endTime,
     Simulator::Stop();
   }
 
-  SecondaryTag secondary;
-  bool isSecondary = ConstCast<Packet>(packet)->PeekPacketTag (secondary);
-
-  uint32_t packetSize = packet->GetSize ();
   WifiMacHeader hdr;
   packet->PeekHeader (hdr);
   NS_LOG_INFO (path << "[hdr]=" << hdr);
 
   if(startAnalysisTime > Seconds (0)){
-    if(hdr.GetType() == WIFI_MAC_DATA){
-      if (packetSize <= 100) {datac[OTHER]->Update();}
-      else if(isSecondary)    {datac[SECONDARY]->Update();}
-      else                    {datac[PRIMARY]->Update();}
-    }else if(hdr.GetType() == WIFI_MAC_CTL_ACK){
-      datac[ACK]->Update();
-    }else if(hdr.GetType() == WIFI_MAC_CTL_BUSY){
-      datac[BUSYTONE]->Update ();
+    int type = ClassifyTxFrame (packet, metadata);
+    if (type >= 0) {datac[type]->Update();}
+  }
+}
+
+void
+MaxTimeReached (Ptr<TimeMinMaxAvgTotalCalculator> endTime)
+{
+  endTime->Update (Simulator::Now());
+  Simulator::Stop();
+}
+
+/**********************************************************
+                   Streamed results
+ ***********************************************************/
+
+// writes the airtime each PHY spent in each state
+void
+WritePhyStateTimes (Ptr<FdResultWriter> results, NetDeviceContainer devices)
+{
+  static const char *states[6] = {"idle", "cca-busy", "tx", "rx", "fd", "switching"};
+  for (uint32_t i = 0; i < devices.GetN (); i++) {
+    Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (devices.Get (i));
+    PointerValue ptr;
+    device->GetPhy ()->GetAttribute ("State", ptr);
+    Ptr<WifiPhyStateHelper> state = ptr.Get<WifiPhyStateHelper> ();
+    std::ostringstream context;
+    context << "node[" << device->GetNode ()->GetId () << "]";
+    for (int j = WifiPhy::IDLE; j <= WifiPhy::SWITCHING; j++) {
+      results->Write (context.str (), std::string ("phy-time-") + states[j],
+                      state->GetStateTime ((WifiPhy::State)j).GetSeconds ());
     }
+    results->Write (context.str (), "phy-time-busytone-padding",
+                    state->GetBusytonePaddingTime ().GetSeconds ());
   }
 }
 
+void
+PhyTxResults (Ptr<FdResultWriter> results, std::string path,
+	      Ptr<const Packet> packet, const FdTxMetadata &metadata)
+{
+  if(startAnalysisTime > Seconds (0)){
+    int type = ClassifyTxFrame (packet, metadata);
+    if (type >= 0) {results->Count (std::string ("phy-tx-") + txTypes[type]);}
+  }
+}
+
+void
+MacMissedAckResults (Ptr<FdResultWriter> results, std::string path, Mac48Address address)
+{
+  if(startAnalysisTime > Seconds (0)){
+    results->Count ("mac-total-missed-ack");
+  }
+}
+
+void
+DelayResults (Ptr<FdResultWriter> results, std::string path, Time delay)
+{
+  results->AddSample (".", "delay", delay.GetSeconds ());
+}
+
 void
 PhyRxBeginCallback (std::string path, Ptr<const Packet> packet)
 {
@@ -165,53 +239,28 @@ PhyRxError (std::string path, Ptr<const Packet> packet, double snr)
 
 
 //----------------------------------------------
-//-- main
+//-- Scenario
 //----------------------------------------------
-int main (int argc, char *argv[]) {
-
+struct ExperimentSettings {
+  string experiment;
+  string strategy;
+  string format;
+  bool   animation;
+  string results;
+  bool   phyStats;
+};
+
+int RunScenario (ExperimentSettings settings, FdScenario scenario, std::string filePrefix) {
+
+  int      nodeAmount = scenario.nodeAmount;
+  double   distance = scenario.distance;
+  double   rate = scenario.rate;
+  string   experiment = settings.experiment;
+  string   strategy = settings.strategy;
+  string   format = settings.format;
+  string   runID = scenario.runId;
+  string   input;
 
-  ns3::Packet::EnablePrinting();
-
-  double   distance = 90;
-  int nodeAmount = 3;
-  double   rate = 0.002;
-  string format ("omnet");
-
-  string experiment ("Full-duplex using directional antenna");
-  string strategy ("Full-duplex using directional antenna");
-  string animFile ("my-wifi-anime.xml");
-  string input;
-  string runID;
-  
-  {
-    stringstream sstr;
-    sstr << "run-" << time (NULL);
-    runID = sstr.str ();
-  }
-
-  // Set up command line parameters used to control the experiment.
-  CommandLine cmd;
-  cmd.AddValue ("distance", "Distance apart to place nodes (in meters).", distance);
-  cmd.AddValue ("format", "Format to use for data output.",format);
-  cmd.AddValue ("experiment", "Identifier for experiment.", experiment);
-  cmd.AddValue ("strategy", "Identifier for strategy.", strategy);
-  cmd.AddValue ("run", "Identifier for run.", runID);
-  cmd.AddValue ("nodeAmount", "Number of nodes", nodeAmount);
-  cmd.AddValue ("rate", "rate", rate);
-  cmd.AddValue ("animFile",  "File Name for Animation Output", animFile);
-  cmd.Parse (argc, argv);
-
-  if (format != "omnet" && format != "db") {
-    NS_LOG_ERROR ("Unknown output format '" << format << "'");
-    return -1;
-  }
-
-#ifndef STATS_HAS_SQLITE3
-  if (format == "db") {
-    NS_LOG_ERROR ("sqlite support not compiled in.");
-    return -1;
-  }
-#endif
   {
     stringstream sstr ("");
     sstr << nodeAmount << "_" << rate;
@@ -233,6 +282,9 @@ int main (int argc, char *argv[]) {
   YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default ();
   wifiPhy.SetChannel (wifiChannel.Create ());
   wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager", "DataMode", StringValue ("OfdmRate6Mbps"));
+  if (settings.phyStats) {
+    wifiPhy.Set ("FrameStats", BooleanValue (true));
+  }
   NetDeviceContainer nodeDevices = wifi.Install (wifiPhy, wifiMac, nodes);
 
   //------------------------------------------------------------
@@ -271,11 +323,15 @@ int main (int argc, char *argv[]) {
   //-- Setup Animation
   //--------------------------------------------
 
-  AnimationInterface::SetNodeDescription (nodes, "Nodes"); // Optional
-  AnimationInterface::SetNodeColor (nodes, 0, 255, 0);     // Optional
-  AnimationInterface anim ("wireless-animation.xml");      // Mandatory
-  anim.EnablePacketMetadata (true); // Optional
-  anim.EnableIpv4RouteTracking ("routingtable-wireless.xml", Seconds (0), Seconds (5), Seconds (0.25)); //Optional
+  // the workers of a batch would all write the same files
+  AnimationInterface *anim = 0;
+  if (settings.animation) {
+    AnimationInterface::SetNodeDescription (nodes, "Nodes"); // Optional
+    AnimationInterface::SetNodeColor (nodes, 0, 255, 0);     // Optional
+    anim = new AnimationInterface ("wireless-animation.xml"); // Mandatory
+    anim->EnablePacketMetadata (true); // Optional
+    anim->EnableIpv4RouteTracking ("routingtable-wireless.xml", Seconds (0), Seconds (5), Seconds (0.25)); //Optional
+  }
 
   //------------------------------------------------------------
   //-- Create a custom traffic source and sink
@@ -334,21 +390,24 @@ int main (int argc, char *argv[]) {
   Ptr<TimeMinMaxAvgTotalCalculator> endTime = CreateObject<TimeMinMaxAvgTotalCalculator>();
 
   std::string strPhy("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/");
-  Config::Connect (strPhy + "PhyTxBegin", MakeBoundCallback (&PhyTxBeginCallback, endTime, phyTotalTxBegin));
-  Config::Connect (strPhy + "PhyRxBegin", MakeCallback (&PhyRxBeginCallback));
-  Config::Connect (strPhy + "PhyRxEnd",   MakeCallback (&PhyRxEndCallback));
-  Config::Connect (strPhy + "PhyRxHeaderEnd",  MakeCallback (&PhyRxHeaderEndCallback));
-  Config::Connect (strPhy + "$ns3::YansWifiPhy/State/RxOk",    MakeCallback (&PhyRxOk));
-  Config::Connect (strPhy + "$ns3::YansWifiPhy/State/RxError", MakeCallback (&PhyRxError));
-
-  std::string types[5];
-  types[PRIMARY]   = "primary";
-  types[SECONDARY] = "secondary";
-  types[BUSYTONE]  = "busytone";
-  types[ACK]       = "ack";
-  types[OTHER]     = "other";
+  if (settings.phyStats) {
+    // the PHYs count their frames: no trace sink runs per frame
+    for (uint32_t i = 0; i < nodeDevices.GetN (); i++) {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (nodeDevices.Get (i));
+      statsPhys.push_back (DynamicCast<YansWifiPhy> (device->GetPhy ()));
+    }
+    Simulator::Schedule (Seconds (MAX_TIME), &MaxTimeReached, endTime);
+  } else {
+    Config::Connect (strPhy + "$ns3::YansWifiPhy/FdTxBegin", MakeBoundCallback (&PhyTxBeginCallback, endTime, phyTotalTxBegin));
+    Config::Connect (strPhy + "PhyRxBegin", MakeCallback (&PhyRxBeginCallback));
+    Config::Connect (strPhy + "PhyRxEnd",   MakeCallback (&PhyRxEndCallback));
+    Config::Connect (strPhy + "PhyRxHeaderEnd",  MakeCallback (&PhyRxHeaderEndCallback));
+    Config::Connect (strPhy + "$ns3::YansWifiPhy/State/RxOk",    MakeCallback (&PhyRxOk));
+    Config::Connect (strPhy + "$ns3::YansWifiPhy/State/RxError", MakeCallback (&PhyRxError));
+  }
+
   for(int i = 0; i < 5; i++){
-    phyTotalTxBegin[i]->SetKey ("phy-tx-" + types[i]);
+    phyTotalTxBegin[i]->SetKey (std::string ("phy-tx-") + txTypes[i]);
     phyTotalTxBegin[i]->SetContext ("node[*]");
     data.AddDataCalculator (phyTotalTxBegin[i]); 
   }
@@ -379,6 +438,20 @@ int main (int argc, char *argv[]) {
   receiver[nodeAmount - 1]->SetDelayTracker (delayStat);
   data.AddDataCalculator (delayStat);
 
+  /* Streamed results, written while the simulation runs */
+  Ptr<FdResultWriter> results = 0;
+  if (!settings.results.empty ()) {
+    results = CreateObject<FdResultWriter> ();
+    if (!results->Open (settings.results + "-" + runID + ".csv")) {
+      return -1;
+    }
+    Config::Connect (strPhy + "$ns3::YansWifiPhy/FdTxBegin", MakeBoundCallback (&PhyTxResults, results));
+    Config::Connect (strMacHigh + "MacTxDataFailed", MakeBoundCallback (&MacMissedAckResults, results));
+    std::ostringstream strDelay;
+    strDelay << "/NodeList/" << nodeAmount - 1 << "/ApplicationList/*/$FdReceiver/Delay";
+    Config::Connect (strDelay.str (), MakeBoundCallback (&DelayResults, results));
+  }
+
   
   //------------------------------------------------------------
   //-- Run the simulation
@@ -386,6 +459,15 @@ int main (int argc, char *argv[]) {
   NS_LOG_INFO ("Run Simulation.");
   Simulator::Run ();
 
+  if (startAnalysisTime > Seconds (0)) {
+    for (uint32_t i = 0; i < statsPhys.size (); i++) {
+      for (int j = 0; j < 5; j++) {
+        phyTotalTxBegin[j]->Update (statsPhys[i]->GetNTxFrames ((YansWifiPhy::FrameClass)j));
+      }
+    }
+  }
+  statsPhys.clear ();
+
   //------------------------------------------------------------
   //-- Generate statistics output.
   //--------------------------------------------
@@ -407,11 +489,107 @@ int main (int argc, char *argv[]) {
   // Finally, have that writer interrogate the DataCollector and save
   // the results.
   if (output != 0) {
+    if (!filePrefix.empty ()) {
+      output->SetFilePrefix (filePrefix);
+    }
     output->Output (data);
   }
 
+  if (results != 0) {
+    WritePhyStateTimes (results, nodeDevices);
+    results->Close ();
+  }
+
   // Free any memory here at the end of this example.
+  delete anim;
   Simulator::Destroy ();
+  return 0;
+
+  // end RunScenario
+}
+
+
+
+//----------------------------------------------
+//-- main
+//----------------------------------------------
+int main (int argc, char *argv[]) {
+
+
+  ns3::Packet::EnablePrinting();
+
+  FdScenario scenario;
+  ExperimentSettings settings;
+  settings.experiment = "Full-duplex using directional antenna";
+  settings.strategy = "Full-duplex using directional antenna";
+  settings.format = "omnet";
+  settings.animation = true;
+  settings.phyStats = false;
+  string animFile ("my-wifi-anime.xml");
+  string grid;
+  string filePrefix;
+  uint32_t jobs = 0;
+  uint32_t runBase = 1;
   
+  {
+    stringstream sstr;
+    sstr << "run-" << time (NULL);
+    scenario.runId = sstr.str ();
+  }
+
+  // Set up command line parameters used to control the experiment.
+  CommandLine cmd;
+  cmd.AddValue ("distance", "Distance apart to place nodes (in meters).", scenario.distance);
+  cmd.AddValue ("format", "Format to use for data output.", settings.format);
+  cmd.AddValue ("experiment", "Identifier for experiment.", settings.experiment);
+  cmd.AddValue ("strategy", "Identifier for strategy.", settings.strategy);
+  cmd.AddValue ("run", "Identifier for run.", scenario.runId);
+  cmd.AddValue ("nodeAmount", "Number of nodes", scenario.nodeAmount);
+  cmd.AddValue ("rate", "rate", scenario.rate);
+  cmd.AddValue ("animFile",  "File Name for Animation Output", animFile);
+  cmd.AddValue ("grid", "Parameter grid file; runs every point of it in a batch.", grid);
+  cmd.AddValue ("jobs", "Worker processes of a batch (0: one per processor).", jobs);
+  cmd.AddValue ("runBase", "RNG run number of the first grid point without one.", runBase);
+  cmd.AddValue ("filePrefix", "Prefix of the data output files.", filePrefix);
+  cmd.AddValue ("phyStats", "Count the frames in the PHYs instead of trace sinks.", settings.phyStats);
+  cmd.AddValue ("results", "Prefix of the streamed CSV results (none if empty).", settings.results);
+  cmd.Parse (argc, argv);
+
+  if (settings.format != "omnet" && settings.format != "db") {
+    NS_LOG_ERROR ("Unknown output format '" << settings.format << "'");
+    return -1;
+  }
+
+#ifndef STATS_HAS_SQLITE3
+  if (settings.format == "db") {
+    NS_LOG_ERROR ("sqlite support not compiled in.");
+    return -1;
+  }
+#endif
+
+  if (grid.empty ()) {
+    return RunScenario (settings, scenario, filePrefix);
+  }
+
+  // Batch: the omnet outputs of the points are merged into one file.
+  if (settings.format != "omnet") {
+    NS_LOG_ERROR ("A batch only supports the omnet output format.");
+    return -1;
+  }
+  settings.animation = false;
+
+  FdBatchRunner batch;
+  if (!filePrefix.empty ()) {
+    batch.SetFilePrefix (filePrefix);
+  }
+  batch.SetJobs (jobs);
+  if (!batch.ReadGrid (grid, runBase)) {
+    return -1;
+  }
+  uint32_t failed = batch.Run (MakeBoundCallback (&RunScenario, settings));
+  std::cout << batch.GetNScenarios () - failed << " of " << batch.GetNScenarios ()
+            << " points written to " << batch.GetMergedFileName () << std::endl;
+  return failed == 0 ? 0 : 1;
+
   // end main
 }
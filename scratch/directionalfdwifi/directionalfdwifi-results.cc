@@ -0,0 +1,184 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdio>
+
+#include "ns3/core-module.h"
+
+#include "directionalfdwifi-results.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("FdWifiResults");
+
+TypeId
+FdResultWriter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("FdResultWriter")
+    .SetParent<Object> ()
+    .AddConstructor<FdResultWriter> ()
+    .AddAttribute ("BlockSize", "Bytes of rows kept in memory before they are written.",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&FdResultWriter::m_blockSize),
+                   MakeUintegerChecker<uint32_t>(1))
+    .AddAttribute ("FlushInterval", "Simulated time between two flushes and snapshots.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&FdResultWriter::m_flushInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("BinWidth", "Width of a histogram bin, in the unit of the samples.",
+                   DoubleValue (0.0001),
+                   MakeDoubleAccessor (&FdResultWriter::m_binWidth),
+                   MakeDoubleChecker<double>(0))
+    .AddAttribute ("Bins", "Number of histogram bins; larger samples are overflows.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&FdResultWriter::m_nBins),
+                   MakeUintegerChecker<uint32_t>(1))
+  ;
+  return tid;
+}
+
+FdResultWriter::Histogram::Histogram ()
+  : overflow (0)
+{
+}
+
+FdResultWriter::FdResultWriter()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+FdResultWriter::~FdResultWriter()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void
+FdResultWriter::DoDispose (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Close ();
+  // chain up
+  Object::DoDispose ();
+}
+
+bool
+FdResultWriter::Open (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  m_file.open (fileName.c_str (), std::ios_base::out | std::ios_base::trunc);
+  if (!m_file.is_open ()) {
+    NS_LOG_ERROR ("Cannot open result file " << fileName);
+    return false;
+  }
+  m_block.reserve (m_blockSize + 256);
+  m_block = "time,context,key,value\n";
+  if (!m_flushInterval.IsZero ()) {
+    m_flushEvent = Simulator::Schedule (m_flushInterval, &FdResultWriter::PeriodicFlush, this);
+  }
+  return true;
+}
+
+void
+FdResultWriter::Close (void)
+{
+  if (!m_file.is_open ()) {
+    return;
+  }
+  m_flushEvent.Cancel ();
+  Snapshot ();
+  Flush ();
+  m_file.close ();
+}
+
+void
+FdResultWriter::Write (std::string context, std::string key, double value)
+{
+  if (!m_file.is_open ()) {
+    return;
+  }
+  char row[64];
+  snprintf (row, sizeof (row), "%.9f,", Simulator::Now ().GetSeconds ());
+  m_block += row;
+  m_block += context;
+  m_block += ',';
+  m_block += key;
+  snprintf (row, sizeof (row), ",%.9g\n", value);
+  m_block += row;
+  if (m_block.size () >= m_blockSize) {
+    Flush ();
+  }
+}
+
+void
+FdResultWriter::Count (std::string key)
+{
+  m_counters[key]++;
+}
+
+void
+FdResultWriter::AddSample (std::string context, std::string key, double value)
+{
+  Write (context, key, value);
+  Histogram &histogram = m_histograms[key];
+  if (histogram.bins.empty ()) {
+    histogram.bins.resize (m_nBins, 0);
+  }
+  double bin = m_binWidth > 0 ? value / m_binWidth : m_nBins;
+  if (bin >= 0 && bin < m_nBins) {
+    histogram.bins[(uint32_t)bin]++;
+  } else {
+    histogram.overflow++;
+  }
+}
+
+void
+FdResultWriter::Snapshot (void)
+{
+  // every snapshot holds the totals so far: the last one of a key wins
+  for (std::map<std::string, uint64_t>::const_iterator i = m_counters.begin ();
+       i != m_counters.end (); i++) {
+    Write ("node[*]", i->first, i->second);
+  }
+  for (std::map<std::string, Histogram>::const_iterator i = m_histograms.begin ();
+       i != m_histograms.end (); i++) {
+    const Histogram &histogram = i->second;
+    char context[32];
+    for (uint32_t j = 0; j < histogram.bins.size (); j++) {
+      if (histogram.bins[j] == 0) {
+        continue;
+      }
+      snprintf (context, sizeof (context), "bin=%.9g", j * m_binWidth);
+      Write (context, i->first + "-hist", histogram.bins[j]);
+    }
+    Write ("overflow", i->first + "-hist", histogram.overflow);
+  }
+}
+
+void
+FdResultWriter::Flush (void)
+{
+  m_file.write (m_block.data (), m_block.size ());
+  m_file.flush ();
+  m_block.clear ();
+}
+
+void
+FdResultWriter::PeriodicFlush (void)
+{
+  Snapshot ();
+  Flush ();
+  m_flushEvent = Simulator::Schedule (m_flushInterval, &FdResultWriter::PeriodicFlush, this);
+}
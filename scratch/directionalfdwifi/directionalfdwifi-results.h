@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Streaming results of one run. The trace sinks of the example feed
+ * the writer while the simulation runs; it appends "time,context,key,value"
+ * rows to a CSV file through a large in-memory block, which goes to the
+ * disk when it is full and every FlushInterval of simulated time. A
+ * run which is killed keeps everything up to its last flush.
+ */
+#ifndef DIRECTIONALFDWIFI_RESULTS_H
+#define DIRECTIONALFDWIFI_RESULTS_H
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+//------------------------------------------------------
+class FdResultWriter : public Object {
+public:
+  static TypeId GetTypeId (void);
+  FdResultWriter();
+  virtual ~FdResultWriter();
+
+  // truncates the file, writes the column names and starts the flushes
+  bool Open (std::string fileName);
+  // writes the last snapshot and closes the file
+  void Close (void);
+
+  // appends one row, stamped with the current simulation time
+  void Write (std::string context, std::string key, double value);
+  // adds one to a counter; counters are written at every flush
+  void Count (std::string key);
+  // appends one row and adds the value to the histogram of the key
+  void AddSample (std::string context, std::string key, double value);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct Histogram {
+    Histogram ();
+    std::vector<uint64_t> bins;
+    uint64_t overflow;
+  };
+
+  void Snapshot (void);
+  void Flush (void);
+  void PeriodicFlush (void);
+
+  uint32_t    m_blockSize;
+  Time        m_flushInterval;
+  double      m_binWidth;
+  uint32_t    m_nBins;
+
+  std::ofstream m_file;
+  std::string   m_block;
+  EventId       m_flushEvent;
+  std::map<std::string, uint64_t>  m_counters;
+  std::map<std::string, Histogram> m_histograms;
+
+  // end class FdResultWriter
+};
+
+#endif /* DIRECTIONALFDWIFI_RESULTS_H */
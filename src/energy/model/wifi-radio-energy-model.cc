@@ -67,9 +67,25 @@ WifiRadioEnergyModel::GetTypeId (void)
                    MakeDoubleAccessor (&WifiRadioEnergyModel::SetSwitchingCurrentA,
                                        &WifiRadioEnergyModel::GetSwitchingCurrentA),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("FdCurrentA",
+                   "The radio current in Ampere while transmitting and receiving at once.",
+                   DoubleValue (0.0371),    // default to be Tx + Rx
+                   MakeDoubleAccessor (&WifiRadioEnergyModel::SetFdCurrentA,
+                                       &WifiRadioEnergyModel::GetFdCurrentA),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SicCurrentA",
+                   "The current in Ampere of the self-interference cancellation, "
+                   "drawn on top of FdCurrentA.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&WifiRadioEnergyModel::SetSicCurrentA,
+                                       &WifiRadioEnergyModel::GetSicCurrentA),
+                   MakeDoubleChecker<double> ())
     .AddTraceSource ("TotalEnergyConsumption",
                      "Total energy consumption of the radio device.",
                      MakeTraceSourceAccessor (&WifiRadioEnergyModel::m_totalEnergyConsumption))
+    .AddTraceSource ("BusytoneEnergyConsumption",
+                     "Energy consumed while transmitting busytone padding.",
+                     MakeTraceSourceAccessor (&WifiRadioEnergyModel::m_busytoneEnergyConsumption))
   ; 
   return tid;
 }
@@ -79,11 +95,13 @@ WifiRadioEnergyModel::WifiRadioEnergyModel ()
   NS_LOG_FUNCTION (this);
   m_currentState = WifiPhy::IDLE;  // initially IDLE
   m_lastUpdateTime = Seconds (0.0);
+  m_busytoneEnergyConsumption = 0.0;
   m_energyDepletionCallback.Nullify ();
   m_source = NULL;
   // set callback for WifiPhy listener
   m_listener = new WifiRadioEnergyModelPhyListener;
-  m_listener->SetChangeStateCallback (MakeCallback (&DeviceEnergyModel::ChangeState, this));
+  m_listener->SetUpdateCallback (MakeCallback (&WifiRadioEnergyModel::ScheduleUpdate, this));
+  m_listener->SetStateHelperCallback (MakeCallback (&WifiRadioEnergyModel::SetPhyStateHelper, this));
 }
 
 WifiRadioEnergyModel::~WifiRadioEnergyModel ()
@@ -177,6 +195,56 @@ WifiRadioEnergyModel::SetSwitchingCurrentA (double switchingCurrentA)
   m_switchingCurrentA = switchingCurrentA;
 }
 
+double
+WifiRadioEnergyModel::GetFdCurrentA (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_fdCurrentA;
+}
+
+void
+WifiRadioEnergyModel::SetFdCurrentA (double fdCurrentA)
+{
+  NS_LOG_FUNCTION (this << fdCurrentA);
+  m_fdCurrentA = fdCurrentA;
+}
+
+double
+WifiRadioEnergyModel::GetSicCurrentA (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sicCurrentA;
+}
+
+void
+WifiRadioEnergyModel::SetSicCurrentA (double sicCurrentA)
+{
+  NS_LOG_FUNCTION (this << sicCurrentA);
+  m_sicCurrentA = sicCurrentA;
+}
+
+double
+WifiRadioEnergyModel::GetBusytoneEnergyConsumption (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_busytoneEnergyConsumption;
+}
+
+void
+WifiRadioEnergyModel::SetPhyStateHelper (Ptr<WifiPhyStateHelper> state)
+{
+  NS_LOG_FUNCTION (this << state);
+  NS_ASSERT (state != 0);
+  m_phyState = state;
+  // only the airtime from now on is charged to this model
+  for (uint32_t i = 0; i <= WifiPhy::SWITCHING; i++)
+    {
+      m_lastStateTimes[i] = state->GetStateTime ((WifiPhy::State) i);
+    }
+  m_lastBusytonePaddingTime = state->GetBusytonePaddingTime ();
+  m_lastUpdateTime = Simulator::Now ();
+  SetWifiRadioState (state->GetState ());
+}
 
 WifiPhy::State
 WifiRadioEnergyModel::GetCurrentState (void) const
@@ -202,43 +270,7 @@ WifiRadioEnergyModel::ChangeState (int newState)
 {
   NS_LOG_FUNCTION (this << newState);
 
-  Time duration = Simulator::Now () - m_lastUpdateTime;
-  NS_ASSERT (duration.GetNanoSeconds () >= 0); // check if duration is valid
-
-  // energy to decrease = current * voltage * time
-  double energyToDecrease = 0.0;
-  double supplyVoltage = m_source->GetSupplyVoltage ();
-  switch (m_currentState)
-    {
-    case WifiPhy::IDLE:
-      energyToDecrease = duration.GetSeconds () * m_idleCurrentA * supplyVoltage;
-      break;
-    case WifiPhy::CCA_BUSY:
-      energyToDecrease = duration.GetSeconds () * m_ccaBusyCurrentA * supplyVoltage;
-      break;
-    case WifiPhy::TX:
-      energyToDecrease = duration.GetSeconds () * m_txCurrentA * supplyVoltage;
-      break;
-    case WifiPhy::RX:
-      energyToDecrease = duration.GetSeconds () * m_rxCurrentA * supplyVoltage;
-      break;
-    case WifiPhy::SWITCHING:
-      energyToDecrease = duration.GetSeconds () * m_switchingCurrentA * supplyVoltage;
-      break;
-    case WifiPhy::FD:
-      break;
-    default:
-      NS_FATAL_ERROR ("WifiRadioEnergyModel:Undefined radio state: " << m_currentState);
-    }
-
-  // update total energy consumption
-  m_totalEnergyConsumption += energyToDecrease;
-
-  // update last update time stamp
-  m_lastUpdateTime = Simulator::Now ();
-
-  // notify energy source
-  m_source->UpdateEnergySource ();
+  UpdateEnergyConsumption ();
 
   // update current state & last update time stamp
   SetWifiRadioState ((WifiPhy::State) newState);
@@ -275,6 +307,8 @@ void
 WifiRadioEnergyModel::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_updateEvent.Cancel ();
+  m_phyState = 0;
   m_source = NULL;
   m_energyDepletionCallback.Nullify ();
 }
@@ -283,7 +317,13 @@ double
 WifiRadioEnergyModel::DoGetCurrentA (void) const
 {
   NS_LOG_FUNCTION (this);
-  switch (m_currentState)
+  return GetStateCurrentA (m_currentState);
+}
+
+double
+WifiRadioEnergyModel::GetStateCurrentA (WifiPhy::State state) const
+{
+  switch (state)
     {
     case WifiPhy::IDLE:
       return m_idleCurrentA;
@@ -296,9 +336,77 @@ WifiRadioEnergyModel::DoGetCurrentA (void) const
     case WifiPhy::SWITCHING:
       return m_switchingCurrentA;
     case WifiPhy::FD:
-      return m_rxCurrentA;
+      return m_fdCurrentA + m_sicCurrentA;
     default:
-      NS_FATAL_ERROR ("WifiRadioEnergyModel:Undefined radio state:" << m_currentState);
+      NS_FATAL_ERROR ("WifiRadioEnergyModel:Undefined radio state:" << state);
+    }
+}
+
+void
+WifiRadioEnergyModel::UpdateEnergyConsumption (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time duration = Simulator::Now () - m_lastUpdateTime;
+  NS_ASSERT (duration.GetNanoSeconds () >= 0); // check if duration is valid
+
+  // energy to decrease = current * voltage * time
+  double supplyVoltage = m_source->GetSupplyVoltage ();
+  double energyToDecrease = 0;
+  if (m_phyState != 0)
+    {
+      // the state helper splits the interval at every state change
+      for (uint32_t i = 0; i <= WifiPhy::SWITCHING; i++)
+        {
+          Time stateTime = m_phyState->GetStateTime ((WifiPhy::State) i);
+          // a reset of the state times restarts the accounting
+          Time elapsed = stateTime < m_lastStateTimes[i] ? stateTime : stateTime - m_lastStateTimes[i];
+          energyToDecrease += elapsed.GetSeconds () * GetStateCurrentA ((WifiPhy::State) i) * supplyVoltage;
+          m_lastStateTimes[i] = stateTime;
+        }
+      Time paddingTime = m_phyState->GetBusytonePaddingTime ();
+      Time padding = paddingTime < m_lastBusytonePaddingTime ? paddingTime : paddingTime - m_lastBusytonePaddingTime;
+      m_busytoneEnergyConsumption += padding.GetSeconds () * m_txCurrentA * supplyVoltage;
+      m_lastBusytonePaddingTime = paddingTime;
+    }
+  else
+    {
+      energyToDecrease = duration.GetSeconds () * DoGetCurrentA () * supplyVoltage;
+    }
+
+  // update total energy consumption
+  m_totalEnergyConsumption += energyToDecrease;
+
+  // update last update time stamp
+  m_lastUpdateTime = Simulator::Now ();
+
+  // notify energy source
+  m_source->UpdateEnergySource ();
+}
+
+void
+WifiRadioEnergyModel::ScheduleUpdate (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_phyState == 0)
+    {
+      NS_FATAL_ERROR ("WifiRadioEnergyModel:Listener not registered on a PHY!");
+    }
+  // the PHY notifies its listeners before it changes its state
+  m_updateEvent.Cancel ();
+  m_updateEvent = Simulator::ScheduleNow (&WifiRadioEnergyModel::UpdateFromPhyState, this);
+}
+
+void
+WifiRadioEnergyModel::UpdateFromPhyState (void)
+{
+  NS_LOG_FUNCTION (this);
+  ChangeState (m_phyState->GetState ());
+  // the state also changes by itself at the end of a period
+  Time next = m_phyState->GetNextStateChangeTime ();
+  if (next != Time::Max ())
+    {
+      m_updateEvent = Simulator::Schedule (next - Simulator::Now (),
+                                           &WifiRadioEnergyModel::UpdateFromPhyState, this);
     }
 }
 
@@ -324,6 +432,7 @@ WifiRadioEnergyModel::SetWifiRadioState (const WifiPhy::State state)
       break;
     case WifiPhy::SWITCHING:
       stateName = "SWITCHING";
+      break;
     case WifiPhy::FD:
       stateName = "FD";
       break;
@@ -333,11 +442,11 @@ WifiRadioEnergyModel::SetWifiRadioState (const WifiPhy::State state)
 }
 
 // -------------------------------------------------------------------------- //
-
 WifiRadioEnergyModelPhyListener::WifiRadioEnergyModelPhyListener ()
 {
   NS_LOG_FUNCTION (this);
-  m_changeStateCallback.Nullify ();
+  m_updateCallback.Nullify ();
+  m_stateHelperCallback.Nullify ();
 }
 
 WifiRadioEnergyModelPhyListener::~WifiRadioEnergyModelPhyListener ()
@@ -346,97 +455,93 @@ WifiRadioEnergyModelPhyListener::~WifiRadioEnergyModelPhyListener ()
 }
 
 void
-WifiRadioEnergyModelPhyListener::SetChangeStateCallback (DeviceEnergyModel::ChangeStateCallback callback)
+WifiRadioEnergyModelPhyListener::SetUpdateCallback (Callback<void> callback)
 {
   NS_LOG_FUNCTION (this << &callback);
   NS_ASSERT (!callback.IsNull ());
-  m_changeStateCallback = callback;
+  m_updateCallback = callback;
 }
 
 void
-WifiRadioEnergyModelPhyListener::NotifyRxStart (Time duration)
+WifiRadioEnergyModelPhyListener::SetStateHelperCallback (Callback<void, Ptr<WifiPhyStateHelper> > callback)
 {
-  NS_LOG_FUNCTION (this << duration);
-  if (m_changeStateCallback.IsNull ())
+  NS_LOG_FUNCTION (this << &callback);
+  NS_ASSERT (!callback.IsNull ());
+  m_stateHelperCallback = callback;
+}
+
+void
+WifiRadioEnergyModelPhyListener::NotifyRegistered (Ptr<WifiPhyStateHelper> state)
+{
+  NS_LOG_FUNCTION (this << state);
+  if (m_stateHelperCallback.IsNull ())
     {
-      NS_FATAL_ERROR ("WifiRadioEnergyModelPhyListener:Change state callback not set!");
+      NS_FATAL_ERROR ("WifiRadioEnergyModelPhyListener:State helper callback not set!");
     }
-  m_changeStateCallback (WifiPhy::RX);
-  m_switchToIdleEvent.Cancel ();
+  m_stateHelperCallback (state);
+}
+
+void
+WifiRadioEnergyModelPhyListener::NotifyRxStart (Time duration)
+{
+  NS_LOG_FUNCTION (this << duration);
+  Update ();
 }
 
 void
 WifiRadioEnergyModelPhyListener::NotifyRxPostpone (Time endTime)
 {
+  NS_LOG_FUNCTION (this << endTime);
+  Update ();
 }
 
 void
 WifiRadioEnergyModelPhyListener::NotifyTxPostpone (Time endTime)
 {
+  NS_LOG_FUNCTION (this << endTime);
+  Update ();
+}
+
+void
+WifiRadioEnergyModelPhyListener::NotifyTxPadding (Time paddingStart)
+{
+  NS_LOG_FUNCTION (this << paddingStart);
+  Update ();
 }
 
 void
 WifiRadioEnergyModelPhyListener::NotifyRxEndOk (void)
 {
   NS_LOG_FUNCTION (this);
-  if (m_changeStateCallback.IsNull ())
-    {
-      NS_FATAL_ERROR ("WifiRadioEnergyModelPhyListener:Change state callback not set!");
-    }
-  m_changeStateCallback (WifiPhy::IDLE);
+  Update ();
 }
 
 void
 WifiRadioEnergyModelPhyListener::NotifyRxEndError (void)
 {
   NS_LOG_FUNCTION (this);
-  if (m_changeStateCallback.IsNull ())
-    {
-      NS_FATAL_ERROR ("WifiRadioEnergyModelPhyListener:Change state callback not set!");
-    }
-  m_changeStateCallback (WifiPhy::IDLE);
+  Update ();
 }
 
 void
 WifiRadioEnergyModelPhyListener::NotifyTxStart (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
-  if (m_changeStateCallback.IsNull ())
-    {
-      NS_FATAL_ERROR ("WifiRadioEnergyModelPhyListener:Change state callback not set!");
-    }
-  m_changeStateCallback (WifiPhy::TX);
-  // schedule changing state back to IDLE after TX duration
-  m_switchToIdleEvent.Cancel ();
-  m_switchToIdleEvent = Simulator::Schedule (duration, &WifiRadioEnergyModelPhyListener::SwitchToIdle, this);
+  Update ();
 }
 
 void
 WifiRadioEnergyModelPhyListener::NotifyMaybeCcaBusyStart (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
-  if (m_changeStateCallback.IsNull ())
-    {
-      NS_FATAL_ERROR ("WifiRadioEnergyModelPhyListener:Change state callback not set!");
-    }
-  m_changeStateCallback (WifiPhy::CCA_BUSY);
-  // schedule changing state back to IDLE after CCA_BUSY duration
-  m_switchToIdleEvent.Cancel ();
-  m_switchToIdleEvent = Simulator::Schedule (duration, &WifiRadioEnergyModelPhyListener::SwitchToIdle, this);
+  Update ();
 }
 
 void
 WifiRadioEnergyModelPhyListener::NotifySwitchingStart (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
-  if (m_changeStateCallback.IsNull ())
-    {
-      NS_FATAL_ERROR ("WifiRadioEnergyModelPhyListener:Change state callback not set!");
-    }
-  m_changeStateCallback (WifiPhy::SWITCHING);
-  // schedule changing state back to IDLE after CCA_BUSY duration
-  m_switchToIdleEvent.Cancel ();
-  m_switchToIdleEvent = Simulator::Schedule (duration, &WifiRadioEnergyModelPhyListener::SwitchToIdle, this);
+  Update ();
 }
 
 /*
@@ -444,14 +549,13 @@ WifiRadioEnergyModelPhyListener::NotifySwitchingStart (Time duration)
  */
 
 void
-WifiRadioEnergyModelPhyListener::SwitchToIdle (void)
+WifiRadioEnergyModelPhyListener::Update (void)
 {
-  NS_LOG_FUNCTION (this);
-  if (m_changeStateCallback.IsNull ())
+  if (m_updateCallback.IsNull ())
     {
-      NS_FATAL_ERROR ("WifiRadioEnergyModelPhyListener:Change state callback not set!");
+      NS_FATAL_ERROR ("WifiRadioEnergyModelPhyListener:Update callback not set!");
     }
-  m_changeStateCallback (WifiPhy::IDLE);
+  m_updateCallback ();
 }
 
 } // namespace ns3
@@ -26,6 +26,7 @@
 #include "ns3/event-id.h"
 #include "ns3/traced-value.h"
 #include "ns3/wifi-phy.h"
+#include "ns3/wifi-phy-state-helper.h"
 
 namespace ns3 {
 
@@ -34,6 +35,9 @@ namespace ns3 {
  * A WifiPhy listener class for notifying the WifiRadioEnergyModel of Wifi radio
  * state change.
  *
+ * The listener does not follow the state itself: every notification asks
+ * the WifiRadioEnergyModel to read the state and the airtime accounted
+ * by the WifiPhyStateHelper once the PHY has applied the change.
  */
 class WifiRadioEnergyModelPhyListener : public WifiPhyListener
 {
@@ -42,81 +46,78 @@ public:
   virtual ~WifiRadioEnergyModelPhyListener ();
 
   /**
-   * \brief Sets the change state callback. Used by helper class.
+   * \brief Sets the callback invoked on each notification. Used by
+   * WifiRadioEnergyModel.
    *
-   * \param callback Change state callback.
+   * \param callback Update callback.
    */
-  void SetChangeStateCallback (DeviceEnergyModel::ChangeStateCallback callback);
+  void SetUpdateCallback (Callback<void> callback);
 
   /**
-   * \brief Switches the WifiRadioEnergyModel to RX state.
+   * \brief Sets the callback invoked when the listener is registered on
+   * the state helper of a PHY. Used by WifiRadioEnergyModel.
    *
+   * \param callback State helper callback.
+   */
+  void SetStateHelperCallback (Callback<void, Ptr<WifiPhyStateHelper> > callback);
+
+  /**
    * \param duration the expected duration of the packet reception.
    *
    * Defined in ns3::WifiPhyListener
    */
   virtual void NotifyRxStart (Time duration);
-
   /**
-   * \brief Switches the WifiRadioEnergyModel back to IDLE state.
-   *
    * Defined in ns3::WifiPhyListener
-   *
-   * Note that for the WifiRadioEnergyModel, the behavior of the function is the
-   * same as NotifyRxEndError.
    */
   virtual void NotifyRxEndOk (void);
-
   /**
-   * \brief Switches the WifiRadioEnergyModel back to IDLE state.
-   *
    * Defined in ns3::WifiPhyListener
-   *
-   * Note that for the WifiRadioEnergyModel, the behavior of the function is the
-   * same as NotifyRxEndOk.
    */
   virtual void NotifyRxEndError (void);
-
   /**
-   * \brief Switches the WifiRadioEnergyModel to TX state and switches back to
-   * IDLE after TX duration.
-   *
    * \param duration the expected transmission duration.
    *
    * Defined in ns3::WifiPhyListener
    */
   virtual void NotifyTxStart (Time duration);
-
   /**
    * \param duration the expected busy duration.
    *
    * Defined in ns3::WifiPhyListener
    */
   virtual void NotifyMaybeCcaBusyStart (Time duration);
-
   /**
    * \param duration the expected channel switching duration.
    *
    * Defined in ns3::WifiPhyListener
    */
   virtual void NotifySwitchingStart (Time duration);
+  /**
+   * \param endTime the new end of the transmission.
+   */
   virtual void NotifyTxPostpone (Time endTime);
+  /**
+   * \param endTime the new end of the reception.
+   */
   virtual void NotifyRxPostpone (Time endTime);
-
-private:
   /**
-   * A helper function that makes scheduling m_changeStateCallback possible.
+   * \param paddingStart the time from which the current transmission
+   * only carries busytone padding.
    */
-  void SwitchToIdle (void);
-
-private:
+  virtual void NotifyTxPadding (Time paddingStart);
   /**
-   * Change state callback used to notify the WifiRadioEnergyModel of a state
-   * change.
+   * \param state the state helper the listener was registered on
+   *
+   * Defined in ns3::WifiPhyListener
    */
-  DeviceEnergyModel::ChangeStateCallback m_changeStateCallback;
+  virtual void NotifyRegistered (Ptr<WifiPhyStateHelper> state);
 
-  EventId m_switchToIdleEvent;
+private:
+  void Update (void);
+
+  Callback<void> m_updateCallback;
+  Callback<void, Ptr<WifiPhyStateHelper> > m_stateHelperCallback;
 };
 
 // -------------------------------------------------------------------------- //
@@ -144,6 +145,16 @@ private:
  * supply voltage as 2.5V and currents as 17.4 mA (TX), 18.8 mA (RX), 20 uA
  * (sleep) and 426 uA (idle).
  *
+ * In the FD state the radio draws FdCurrentA, by default the sum of the
+ * Tx and Rx currents, plus SicCurrentA for the self-interference
+ * cancellation. The energy spent while a transmission only carries
+ * busytone padding, counted at TxCurrentA, is also accumulated on its own.
+ *
+ * The energy is integrated from the per-state airtime of the
+ * WifiPhyStateHelper of the PHY the listener is registered on, which
+ * passes itself to the listener (see WifiPhyListener::NotifyRegistered),
+ * so the usual install by WifiRadioEnergyModelHelper is enough.
+ *
  */
 class WifiRadioEnergyModel : public DeviceEnergyModel
 {
@@ -185,6 +196,25 @@ public:
   void SetRxCurrentA (double rxCurrentA);
   double GetSwitchingCurrentA (void) const;
   void SetSwitchingCurrentA (double switchingCurrentA);
+  double GetFdCurrentA (void) const;
+  void SetFdCurrentA (double fdCurrentA);
+  double GetSicCurrentA (void) const;
+  void SetSicCurrentA (double sicCurrentA);
+
+  /**
+   * \returns Energy consumed while transmitting busytone padding, which
+   * is included in the total energy consumption.
+   */
+  double GetBusytoneEnergyConsumption (void) const;
+
+  /**
+   * \param state the state helper of the PHY the listener of this
+   * model is registered on (the "State" attribute of YansWifiPhy)
+   *
+   * Called when the listener is registered on the PHY, e.g. by
+   * WifiRadioEnergyModelHelper.
+   */
+  void SetPhyStateHelper (Ptr<WifiPhyStateHelper> state);
 
   /**
    * \returns Current state.
@@ -238,6 +268,30 @@ private:
    */
   void SetWifiRadioState (const WifiPhy::State state);
 
+  /**
+   * \param state a radio state
+   * \returns the current draw of the device in this state
+   */
+  double GetStateCurrentA (WifiPhy::State state) const;
+
+  /**
+   * Adds the energy consumed since the last update to the totals and
+   * notifies the energy source.
+   */
+  void UpdateEnergyConsumption (void);
+
+  /**
+   * Called by the listener: updates the state from the state helper
+   * at the end of the current event, once the PHY applied the change.
+   */
+  void ScheduleUpdate (void);
+
+  /**
+   * Integrates the energy, reads the state from the state helper and
+   * schedules the next update at its next state change.
+   */
+  void UpdateFromPhyState (void);
+
 private:
   Ptr<EnergySource> m_source;
 
@@ -247,9 +301,19 @@ private:
   double m_idleCurrentA;
   double m_ccaBusyCurrentA;
   double m_switchingCurrentA;
+  double m_fdCurrentA;
+  double m_sicCurrentA;
 
   // This variable keeps track of the total energy consumed by this model.
   TracedValue<double> m_totalEnergyConsumption;
+  // The part of it spent on busytone padding.
+  TracedValue<double> m_busytoneEnergyConsumption;
+
+  // Per-state airtime of the PHY at the last update.
+  Ptr<WifiPhyStateHelper> m_phyState;
+  Time m_lastStateTimes[WifiPhy::SWITCHING + 1];
+  Time m_lastBusytonePaddingTime;
+  EventId m_updateEvent;
 
   // State variables.
   WifiPhy::State m_currentState;  // current state the radio is in
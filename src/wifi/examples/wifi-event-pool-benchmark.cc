@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014 Yusuke Sugiyama
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., Saruwatari Lab, Shizuoka University, Japan
+ *
+ * Author: Yusuke Sugiyama <sugiyama@aurum.cs.inf.shizuoka.ac.jp>
+ */
+
+/*
+ * Feeds one InterferenceHelper with the receptions a YansWifiPhy sees
+ * when nNodes neighbours transmit in turn: every frame adds a header
+ * and a payload event, which stay referenced until the end of the
+ * frame. Prints how many events were created per simulated second and
+ * how many of them needed a heap allocation; without the event pool
+ * both numbers would be the same.
+ *
+ *   ./waf --run "wifi-event-pool-benchmark --nNodes=50 --simTime=10"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/interference-helper.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+static void
+EndReceive (InterferenceHelper *interference, Ptr<InterferenceHelper::Event> header,
+            Ptr<InterferenceHelper::Event> payload)
+{
+  interference->NotifyRxEnd ();
+}
+
+static void
+Receive (InterferenceHelper *interference, std::vector<Mac48Address> *senders,
+         uint32_t next, Time interval, Time frameDuration)
+{
+  WifiMode mode = WifiPhy::GetOfdmRate6Mbps ();
+  WifiTxVector txVector;
+  txVector.SetMode (mode);
+  Time now = Simulator::Now ();
+  Time endHeader = now + MicroSeconds (20);
+  Mac48Address sender = (*senders)[next];
+
+  Ptr<InterferenceHelper::Event> header;
+  header = interference->Add (1500, mode, WIFI_PREAMBLE_LONG, now, endHeader,
+                              1e-9, txVector, sender);
+  Ptr<InterferenceHelper::Event> payload;
+  payload = interference->Add (1500, mode, WIFI_PREAMBLE_LONG, endHeader, now + frameDuration,
+                               1e-9, txVector, sender);
+  interference->NotifyRxStart ();
+  Simulator::Schedule (frameDuration, &EndReceive, interference, header, payload);
+
+  Simulator::Schedule (interval, &Receive, interference, senders,
+                       (next + 1) % senders->size (), interval, frameDuration);
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nNodes = 50;
+  double simTime = 10;
+  double frameDurationUs = 2000;
+  double intervalUs = 2500;
+
+  CommandLine cmd;
+  cmd.AddValue ("nNodes", "Number of transmitting neighbours", nNodes);
+  cmd.AddValue ("simTime", "Simulated time (s)", simTime);
+  cmd.AddValue ("frameDuration", "Duration of a frame (us)", frameDurationUs);
+  cmd.AddValue ("interval", "Time between the starts of two frames (us)", intervalUs);
+  cmd.Parse (argc, argv);
+
+  std::vector<Mac48Address> senders;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      senders.push_back (Mac48Address::Allocate ());
+    }
+
+  InterferenceHelper interference;
+  interference.SetNoiseFigure (std::pow (10.0, 7 / 10.0));
+  interference.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+
+  Simulator::Schedule (Seconds (0), &Receive, &interference, &senders, 0,
+                       MicroSeconds (intervalUs), MicroSeconds (frameDurationUs));
+  Simulator::Stop (Seconds (simTime));
+  Simulator::Run ();
+
+  Ptr<const InterferenceHelper::EventPool> pool = interference.GetEventPool ();
+  uint64_t created = pool->GetNAllocations () + pool->GetNReuses ();
+  std::cout << "events created:       " << created
+            << " (" << created / simTime << " /s)" << std::endl;
+  std::cout << "heap allocations:     " << pool->GetNAllocations ()
+            << " (" << pool->GetNAllocations () / simTime << " /s)" << std::endl;
+  std::cout << "recycled from pool:   " << pool->GetNReuses () << std::endl;
+  std::cout << "events indexed (max): " << interference.GetNEvents ()
+            << " (" << interference.GetMaxNEvents () << ")" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -33,6 +33,8 @@
 #include "ns3/names.h"
 #include "ns3/abort.h"
 #include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
 
 #include "ns3/wifi-switched-beam-antenna-model.h"
 #include "ns3/constant-orientation-model.h"
@@ -94,6 +96,7 @@ AsciiPhyReceiveSinkWithoutContext (
 
 YansWifiChannelHelper::YansWifiChannelHelper ()
 {
+  m_channel.SetTypeId ("ns3::YansWifiChannel");
 }
 
 YansWifiChannelHelper
@@ -156,7 +159,7 @@ YansWifiChannelHelper::SetPropagationDelay (std::string type,
 Ptr<YansWifiChannel>
 YansWifiChannelHelper::Create (void) const
 {
-  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  Ptr<YansWifiChannel> channel = m_channel.Create<YansWifiChannel> ();
   Ptr<PropagationLossModel> prev = 0;
   for (std::vector<ObjectFactory>::const_iterator i = m_propagationLoss.begin (); i != m_propagationLoss.end (); ++i)
     {
@@ -176,6 +179,19 @@ YansWifiChannelHelper::Create (void) const
   return channel;
 }
 
+void
+YansWifiChannelHelper::Set (std::string name, const AttributeValue &v)
+{
+  m_channel.Set (name, v);
+}
+
+void
+YansWifiChannelHelper::EnableSpatialIndex (double maxRange)
+{
+  m_channel.Set ("SpatialIndex", BooleanValue (true));
+  m_channel.Set ("MaxRange", DoubleValue (maxRange));
+}
+
 int64_t 
 YansWifiChannelHelper::AssignStreams (Ptr<YansWifiChannel> c, int64_t stream)
 {
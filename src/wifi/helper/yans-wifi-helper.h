@@ -127,6 +127,25 @@ public:
    */
   Ptr<YansWifiChannel> Create (void) const;
 
+  /**
+   * \param name the name of the attribute to set
+   * \param v the value of the attribute
+   *
+   * Set an attribute of the underlying channel object.
+   */
+  void Set (std::string name, const AttributeValue &v);
+
+  /**
+   * \param maxRange the distance (m) beyond which receivers are culled
+   *
+   * Make the created channels only schedule receptions on the PHYs
+   * closer than maxRange, using a grid index of the PHY positions. The
+   * cells of the moving PHYs (non-zero velocity or a CourseChange since
+   * the last refresh) are refreshed from their positions once per time
+   * step. The result is the same as the brute-force MaxRange cutoff.
+   */
+  void EnableSpatialIndex (double maxRange);
+
   /**
   * Assign a fixed random variable stream number to the random variables
   * used by the channel.  Typically this corresponds to random variables
@@ -144,6 +163,7 @@ public:
 private:
   std::vector<ObjectFactory> m_propagationLoss;
   ObjectFactory m_propagationDelay;
+  ObjectFactory m_channel;
 };
 
 /**
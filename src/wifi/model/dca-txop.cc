@@ -25,6 +25,7 @@
 #include "ns3/node.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
 
 #include "dca-txop.h"
 #include "dcf-manager.h"
@@ -34,6 +35,9 @@
 #include "wifi-mac-trailer.h"
 #include "wifi-mac.h"
 #include "random-stream.h"
+#include "msdu-standard-aggregator.h"
+
+#include <list>
 
 NS_LOG_COMPONENT_DEFINE ("DcaTxop");
 
@@ -133,6 +137,18 @@ DcaTxop::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&DcaTxop::GetQueue),
                    MakePointerChecker<WifiMacQueue> ())
+    .AddAttribute ("SecondaryAggregation",
+                   "Fill the time left before the end of the primary transmission "
+                   "with further packets for the same receiver, aggregated into an "
+                   "A-MSDU, instead of busytone. The aggregate is sent as a QoS data "
+                   "frame, which the receivers must be able to deaggregate.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DcaTxop::m_secondaryAggregation),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SecondaryAggregator", "The aggregator used for secondary transmissions",
+                   PointerValue (),
+                   MakePointerAccessor (&DcaTxop::m_secondaryAggregator),
+                   MakePointerChecker<MsduAggregator> ())
   ;
   return tid;
 }
@@ -145,6 +161,7 @@ DcaTxop::DcaTxop ()
   m_transmissionListener = new DcaTxop::TransmissionListener (this);
   m_dcf = new DcaTxop::Dcf (this);
   m_queue = CreateObject<WifiMacQueue> ();
+  m_secondaryAggregator = CreateObject<MsduStandardAggregator> ();
   m_rng = new RealRandomStream ();
 }
 
@@ -158,6 +175,7 @@ DcaTxop::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_queue = 0;
+  m_secondaryAggregator = 0;
   m_low = 0;
   m_stationManager = 0;
   delete m_transmissionListener;
@@ -268,7 +286,13 @@ DcaTxop::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
   m_rng->AssignStreams (stream);
-  return 1;
+  // the MacLow is shared by all the queues of the device: only the
+  // DcaTxop which serves the full-duplex transmissions seeds it
+  if (m_low == 0 || m_low->GetDcaTxop () != this)
+    {
+      return 1;
+    }
+  return 1 + m_low->AssignStreams (stream + 1);
 }
 
 void
@@ -441,13 +465,8 @@ DcaTxop::NotifySecondaryTransmissionRequested ()
 bool
 DcaTxop::IsSecondaryTransmissionGranted (void)
 {
-  NS_LOG_FUNCTION (m_manager->IsBusyForFullDuplex() << m_manager->GetSecondaryGrantedTime () << Simulator::Now());
-  if (!m_manager->IsBusyForFullDuplex() &&
-      m_manager->GetSecondaryGrantedTime () <= Simulator::Now())
-    {
-      return true;
-    }
-  return false;
+  NS_LOG_FUNCTION (m_manager->IsBusyForFullDuplex() << m_manager->GetSecondaryGrantedTime (m_dcf) << Simulator::Now());
+  return m_manager->IsSecondaryAccessGranted (m_dcf);
 }
 
 bool
@@ -480,6 +499,10 @@ DcaTxop::SecondaryTransmissionGranted (void)
         }
       m_currentPacket = m_queue->Dequeue (&m_currentHdr);
       NS_ASSERT (m_currentPacket != 0);
+      // an aggregate is a QoS data frame, which takes its sequence
+      // number from the counter of its TID: draw it once the header is
+      // final
+      AggregateSecondary ();
       uint16_t sequence = m_txMiddle->GetNextSequenceNumberfor (&m_currentHdr);
       m_currentHdr.SetSequenceNumber (sequence);
       m_currentHdr.SetFragmentNumber (0);
@@ -551,6 +574,84 @@ DcaTxop::SecondaryTransmissionGranted (void)
     }
 }
 
+void
+DcaTxop::AggregateSecondary (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_secondaryAggregation
+      || m_currentHdr.GetAddr1 ().IsGroup ()
+      || m_currentHdr.GetType () != WIFI_MAC_DATA
+      || NeedFragmentation ())
+    {
+      return;
+    }
+  Mac48Address dest = m_currentHdr.GetAddr1 ();
+  Mac48Address src = m_currentHdr.GetAddr2 ();
+  if (m_queue->IsEmpty ())
+    {
+      return;
+    }
+
+  // the header of the aggregate, used to check the airtime
+  WifiMacHeader aggregatedHdr = m_currentHdr;
+  aggregatedHdr.SetType (WIFI_MAC_QOSDATA);
+  // the DCF queue carries best-effort traffic
+  aggregatedHdr.SetQosTid (0);
+  aggregatedHdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
+  aggregatedHdr.SetQosAmsdu ();
+  aggregatedHdr.SetQosNoEosp ();
+  aggregatedHdr.SetQosTxopLimit (0);
+
+  Ptr<Packet> aggregated = Create<Packet> ();
+  if (!m_secondaryAggregator->Aggregate (m_currentPacket, aggregated, src, dest))
+    {
+      return;
+    }
+  uint32_t nMsdus = 1;
+  // The DCF queue carries no TID, so it is scanned in order: the MSDUs for
+  // other destinations are taken out and put back in front afterwards.
+  std::list<std::pair<Ptr<const Packet>, WifiMacHeader> > skipped;
+  uint32_t nQueued = m_queue->GetSize ();
+  for (uint32_t i = 0; i < nQueued; i++)
+    {
+      WifiMacHeader queuedHdr;
+      Ptr<const Packet> queued = m_queue->Dequeue (&queuedHdr);
+      if (queued == 0)
+        {
+          break;
+        }
+      if (queuedHdr.GetType () != WIFI_MAC_DATA
+          || queuedHdr.GetAddr1 () != dest)
+        {
+          skipped.push_back (std::make_pair (queued, queuedHdr));
+          continue;
+        }
+      Ptr<Packet> candidate = aggregated->Copy ();
+      // an A-MSDU cannot be fragmented
+      if (!m_secondaryAggregator->Aggregate (queued, candidate, src, dest)
+          || m_stationManager->NeedFragmentation (dest, &aggregatedHdr, candidate)
+          || Low ()->GetSecondaryRemainingTime (candidate, &aggregatedHdr).IsStrictlyNegative ())
+        {
+          skipped.push_back (std::make_pair (queued, queuedHdr));
+          break;
+        }
+      aggregated = candidate;
+      nMsdus++;
+    }
+  for (std::list<std::pair<Ptr<const Packet>, WifiMacHeader> >::reverse_iterator it = skipped.rbegin ();
+       it != skipped.rend (); it++)
+    {
+      m_queue->PushFront (it->first, it->second);
+    }
+  if (nMsdus == 1)
+    {
+      return;
+    }
+  NS_LOG_DEBUG ("aggregated " << nMsdus << " msdus, size=" << aggregated->GetSize ());
+  m_currentPacket = aggregated;
+  m_currentHdr = aggregatedHdr;
+}
+
 void
 DcaTxop::NotifyAccessGranted (void)
 {
@@ -42,6 +42,7 @@ class MacTxMiddle;
 class RandomStream;
 class MacStation;
 class MacStations;
+class MsduAggregator;
 
 /**
  * \brief handle packet fragmentation and retransmissions.
@@ -317,6 +318,15 @@ private:
    * \return the fragment with the current fragment number
    */
   Ptr<Packet> GetFragmentPacket (WifiMacHeader *hdr);
+  /**
+   * Aggregate the queued packets which go to the same receiver, in queue
+   * order, into the current packet (A-MSDU), as long as the secondary
+   * transmission still ends before the primary one and the aggregate
+   * needs no fragmentation. The header becomes a QoS data header with
+   * the A-MSDU bit set if anything was added. Must be called before the
+   * sequence number is assigned.
+   */
+  void AggregateSecondary (void);
   virtual void DoDispose (void);
 
   Dcf *m_dcf;
@@ -326,6 +336,8 @@ private:
   Ptr<WifiMacQueue> m_queue;
   MacTxMiddle *m_txMiddle;
   Ptr <MacLow> m_low;
+  bool m_secondaryAggregation;
+  Ptr<MsduAggregator> m_secondaryAggregator;
   Ptr<WifiRemoteStationManager> m_stationManager;
   TransmissionListener *m_transmissionListener;
   RandomStream *m_rng;
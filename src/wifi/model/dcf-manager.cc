@@ -284,6 +284,8 @@ DcfManager::DcfManager ()
     m_lastBusyDuration (MicroSeconds (0)),
     m_lastSwitchingStart (MicroSeconds (0)),
     m_lastSwitchingDuration (MicroSeconds (0)),
+    m_secondaryBusyEnd (MicroSeconds (0)),
+    m_fullDuplexBusyEnd (MicroSeconds (0)),
     m_rxing (false),
     m_slotTimeUs (0),
     m_sifs (Seconds (0.0)),
@@ -581,22 +583,30 @@ Time
 DcfManager::GetAccessGrantStartForSecondary (void) const
 {
   NS_LOG_FUNCTION (this);
+  return m_secondaryBusyEnd + m_sifs;
+}
 
-  Time txAccessStart = m_lastTxStart + m_lastTxDuration + m_sifs;
-  Time navAccessStart = m_lastNavStart + m_lastNavDuration + m_sifs;
-  Time ackTimeoutAccessStart = m_lastAckTimeoutEnd + m_sifs;
-  Time ctsTimeoutAccessStart = m_lastCtsTimeoutEnd + m_sifs;
-  Time switchingAccessStart = m_lastSwitchingStart + m_lastSwitchingDuration + m_sifs;
-  Time accessGrantedStart = MostRecent (txAccessStart,
-                                        navAccessStart,
-                                        ackTimeoutAccessStart,
-                                        ctsTimeoutAccessStart,
-                                        switchingAccessStart
-                                        );
-  NS_LOG_INFO ("access grant start=" << accessGrantedStart <<
-               ", tx access start=" << txAccessStart <<
-               ", nav access start=" << navAccessStart);
-  return accessGrantedStart;
+void
+DcfManager::UpdateSecondaryAccess (void)
+{
+  m_fullDuplexBusyEnd = Max (m_lastTxStart + m_lastTxDuration,
+                             m_lastNavStart + m_lastNavDuration);
+  m_secondaryBusyEnd = MostRecent (m_fullDuplexBusyEnd,
+                                   m_lastAckTimeoutEnd,
+                                   m_lastCtsTimeoutEnd,
+                                   m_lastSwitchingStart + m_lastSwitchingDuration);
+  NS_LOG_DEBUG ("secondary busy end=" << m_secondaryBusyEnd <<
+                ", full duplex busy end=" << m_fullDuplexBusyEnd);
+}
+
+void
+DcfManager::ExtendSecondaryAccess (Time end, bool fullDuplexBusy)
+{
+  m_secondaryBusyEnd = Max (m_secondaryBusyEnd, end);
+  if (fullDuplexBusy)
+    {
+      m_fullDuplexBusyEnd = Max (m_fullDuplexBusyEnd, end);
+    }
 }
 
 Time
@@ -616,16 +626,27 @@ DcfManager::GetBackoffEndFor (DcfState *state)
 }
 
 Time
-DcfManager::GetSecondaryGrantedTime ()
+DcfManager::GetSecondaryGrantedTime (DcfState *state) const
 {
-  for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
+  return GetAccessGrantStartForSecondary () + MicroSeconds (state->GetAifsn () * m_slotTimeUs);
+}
+
+Time
+DcfManager::GetSecondaryGrantedTime (void) const
+{
+  Time earliest = Simulator::GetMaximumSimulationTime ();
+  for (States::const_iterator i = m_states.begin (); i != m_states.end (); i++)
     {
-      DcfState *state = *i;
-      Time accessGrantTime = GetAccessGrantStartForSecondary () + MicroSeconds (state->GetAifsn () * m_slotTimeUs);
-      //      return accessGrantTime + MicroSeconds (state->GetBackoffSlots () * m_slotTimeUs);
-      return accessGrantTime;
+      earliest = Min (earliest, GetSecondaryGrantedTime (*i));
     }
-  return Seconds(0);
+  return earliest;
+}
+
+bool
+DcfManager::IsSecondaryAccessGranted (DcfState *state) const
+{
+  Time now = Simulator::Now ();
+  return m_fullDuplexBusyEnd <= now && GetSecondaryGrantedTime (state) <= now;
 }
 
 void
@@ -708,22 +729,11 @@ DcfManager::CancelAccessRequested ()
 }
 
 bool
-DcfManager::IsBusyForFullDuplex ()
+DcfManager::IsBusyForFullDuplex (void) const
 {
   NS_LOG_FUNCTION (this);
-  // PHY busy
-  Time lastTxEnd = m_lastTxStart + m_lastTxDuration;
-  if (lastTxEnd > Simulator::Now ())
-    {
-      return true;
-    }
-  // NAV busy
-  Time lastNavEnd = m_lastNavStart + m_lastNavDuration;
-  if (lastNavEnd > Simulator::Now ())
-    {
-      return true;
-    }
-  return false;
+  // PHY or NAV busy
+  return m_fullDuplexBusyEnd > Simulator::Now ();
 }
 
 void
@@ -762,6 +772,7 @@ DcfManager::NotifyTxStartNow (Time duration)
   UpdateBackoff ();
   m_lastTxStart = Simulator::Now ();
   m_lastTxDuration = duration;
+  ExtendSecondaryAccess (m_lastTxStart + m_lastTxDuration, true);
 }
 void
 DcfManager::NotifyTxPostponeNow (Time endTime)
@@ -770,6 +781,7 @@ DcfManager::NotifyTxPostponeNow (Time endTime)
   UpdateBackoff ();
   if (endTime > m_lastTxStart + m_lastTxDuration){
     m_lastTxDuration = endTime - m_lastTxStart;
+    ExtendSecondaryAccess (endTime, true);
   }
 }
 void
@@ -847,6 +859,7 @@ DcfManager::NotifySwitchingStartNow (Time duration)
   MY_DEBUG ("switching start for " << duration);
   m_lastSwitchingStart = Simulator::Now ();
   m_lastSwitchingDuration = duration;
+  UpdateSecondaryAccess ();
 
 }
 
@@ -858,6 +871,7 @@ DcfManager::NotifyNavResetNow (Time duration)
   UpdateBackoff ();
   m_lastNavStart = Simulator::Now ();
   m_lastNavDuration = duration;
+  UpdateSecondaryAccess ();
   UpdateBackoff ();
   /**
    * If the nav reset indicates an end-of-nav which is earlier
@@ -880,6 +894,7 @@ DcfManager::NotifyNavStartNow (Time duration)
     {
       m_lastNavStart = Simulator::Now ();
       m_lastNavDuration = duration;
+      ExtendSecondaryAccess (newNavEnd, true);
     }
 }
 void
@@ -888,12 +903,14 @@ DcfManager::NotifyAckTimeoutStartNow (Time duration)
   NS_LOG_FUNCTION (this << duration);
   NS_ASSERT (m_lastAckTimeoutEnd < Simulator::Now ());
   m_lastAckTimeoutEnd = Simulator::Now () + duration;
+  ExtendSecondaryAccess (m_lastAckTimeoutEnd, false);
 }
 void
 DcfManager::NotifyAckTimeoutResetNow ()
 {
   NS_LOG_FUNCTION (this);
   m_lastAckTimeoutEnd = Simulator::Now ();
+  UpdateSecondaryAccess ();
   DoRestartAccessTimeoutIfNeeded ();
 }
 void
@@ -901,12 +918,14 @@ DcfManager::NotifyCtsTimeoutStartNow (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
   m_lastCtsTimeoutEnd = Simulator::Now () + duration;
+  ExtendSecondaryAccess (m_lastCtsTimeoutEnd, false);
 }
 void
 DcfManager::NotifyCtsTimeoutResetNow ()
 {
   NS_LOG_FUNCTION (this);
   m_lastCtsTimeoutEnd = Simulator::Now ();
+  UpdateSecondaryAccess ();
   DoRestartAccessTimeoutIfNeeded ();
 }
 } // namespace ns3
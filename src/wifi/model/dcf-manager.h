@@ -370,10 +370,44 @@ public:
   void NotifyRxPostponeNow (Time endTime);
 
   void CancelAccessRequested();
-  bool IsBusyForFullDuplex (void);
-  Time GetSecondaryGrantedTime ();
+  /**
+   * \return true if the own transmission or the NAV forbid a secondary
+   *         transmission now
+   */
+  bool IsBusyForFullDuplex (void) const;
+  /**
+   * \param state the DcfState which wants to send a secondary transmission
+   * \return the time from which state may send a secondary transmission:
+   *         its AIFS after the secondary access start
+   */
+  Time GetSecondaryGrantedTime (DcfState *state) const;
+  /**
+   * \return the earliest secondary granted time over all the DcfStates
+   */
+  Time GetSecondaryGrantedTime (void) const;
+  /**
+   * \param state the DcfState which wants to send a secondary transmission
+   * \return true if state may send a secondary transmission now
+   */
+  bool IsSecondaryAccessGranted (DcfState *state) const;
+  /**
+   * \return SIFS after the end of the own transmission, the NAV, the
+   *         ACK and CTS timeouts and the channel switching
+   */
   Time GetAccessGrantStartForSecondary (void) const;
 private:
+  /**
+   * Recompute the end of the periods which delay a secondary
+   * transmission after one of them was cut short.
+   */
+  void UpdateSecondaryAccess (void);
+  /**
+   * Extend the periods which delay a secondary transmission.
+   *
+   * \param end the end of the new busy period
+   * \param fullDuplexBusy true if the period also forbids full duplex
+   */
+  void ExtendSecondaryAccess (Time end, bool fullDuplexBusy);
   /**
    * Update backoff slots for all DcfStates.
    */
@@ -504,6 +538,12 @@ private:
   Time m_lastBusyDuration;
   Time m_lastSwitchingStart;
   Time m_lastSwitchingDuration;
+  /*
+   * kept up to date by the Notify*Now methods so that the full-duplex
+   * checks on every header reception are single comparisons
+   */
+  Time m_secondaryBusyEnd;   //!< latest end of tx, NAV, timeouts and switching
+  Time m_fullDuplexBusyEnd;  //!< latest end of tx and NAV
   bool m_rxing;
   Time m_eifsNoDifs;
   EventId m_accessTimeout;
@@ -0,0 +1,48 @@
+/* -*- Mode:C++; -*- */
+/*
+ * Copyright (c) 2014 Yusuke Sugiyama
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., Saruwatari Lab, Shizuoka University, Japan
+ *
+ * Author: Yusuke Sugiyama <sugiyama@aurum.cs.inf.shizuoka.ac.jp>
+ */
+
+#include "fd-tx-metadata.h"
+
+namespace ns3 {
+
+FdTxMetadata::FdTxMetadata ()
+  : busytoneDuration (Seconds (0)),
+    secondary (false),
+    source (Mac48Address ()),
+    position (Vector ()),
+    hasPosition (false),
+    antennaSector (0)
+{
+}
+
+std::ostream & operator << (std::ostream &os, const FdTxMetadata &metadata)
+{
+  os << "busytoneDuration=" << metadata.busytoneDuration
+     << ", secondary=" << metadata.secondary
+     << ", source=" << metadata.source
+     << ", antennaSector=" << metadata.antennaSector;
+  if (metadata.hasPosition)
+    {
+      os << ", position=" << metadata.position;
+    }
+  return os;
+}
+
+} // namespace ns3
@@ -0,0 +1,68 @@
+/* -*- Mode:C++; -*- */
+/*
+ * Copyright (c) 2014 Yusuke Sugiyama
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., Saruwatari Lab, Shizuoka University, Japan
+ *
+ * Author: Yusuke Sugiyama <sugiyama@aurum.cs.inf.shizuoka.ac.jp>
+ */
+
+#ifndef FD_TX_METADATA_H
+#define FD_TX_METADATA_H
+
+#include <ostream>
+#include <stdint.h>
+#include "ns3/mac48-address.h"
+#include "ns3/vector.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * Full-duplex information about one transmission. The sender fills it
+ * in once, YansWifiChannel hands the same record to every receiver next
+ * to the packet, and the receiving phy passes it on to MacLow. It takes
+ * the place of the BusytoneTag, SecondaryTag, SourceTag and GeographyTag
+ * which had to be looked up in the tag list of every copy of the frame.
+ */
+struct FdTxMetadata
+{
+  FdTxMetadata ();
+
+  /**
+   * Busytone padding sent after the frame to keep the channel busy
+   * until the end of the other transmission; 0 when the transmission
+   * is not padded. It is a whole number of payload symbols of the
+   * frame, see WifiPhy::GetBusytoneDuration.
+   */
+  Time busytoneDuration;
+  /// true for a secondary transmission
+  bool secondary;
+  /// address of the node which transmits the frame
+  Mac48Address source;
+  /// position of the sender at the start of the transmission
+  Vector position;
+  /// true if position is valid
+  bool hasPosition;
+  /// antenna mode of the sender at the start of the transmission
+  int antennaSector;
+};
+
+std::ostream & operator << (std::ostream &os, const FdTxMetadata &metadata);
+
+} // namespace ns3
+
+#endif /* FD_TX_METADATA_H */
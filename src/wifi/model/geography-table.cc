@@ -24,6 +24,10 @@ n * published by the Free Software Foundation;
 #include "ns3/random-variable-stream.h"
 #include "ns3/mac48-address.h"
 #include "ns3/double.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+#include "ns3/wifi-antenna-model.h"
+#include "mac48-address-hash.h"
 
 NS_LOG_COMPONENT_DEFINE ("GeographyTable");
 
@@ -35,72 +39,115 @@ GeographyTable::GetTypeId (void)
   static TypeId tid = TypeId ("GeographyTable")
     .SetParent<Object> ()
     .AddConstructor<GeographyTable> ()
+    .AddAttribute ("MaxAge",
+                   "Positions which have not been updated for this time are "
+                   "ignored and may be dropped. 0 keeps them forever.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&GeographyTable::m_maxAge),
+                   MakeTimeChecker ())
+    .AddAttribute ("SectorUpdateDistance",
+                   "The distance in meters the node or a neighbour may move before "
+                   "the antenna sector pointing at the neighbour is resolved again.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&GeographyTable::m_sectorUpdateDistance),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("PositionInterval",
+                   "The minimum time between two frames carrying the own position. "
+                   "0 sends it with every frame.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&GeographyTable::m_positionInterval),
+                   MakeTimeChecker ())
     ;
   return tid;
 }
 
 GeographyTable::GeographyTable ()
+  : m_positionSent (false)
 {
   InitItem();
 }
 
 GeographyTable::~GeographyTable ()
 {
-  InitItem();
 }
 
 Angles
 GeographyTable::GetAngle(Mac48Address address, const Vector &position, bool *existsAddress)
 {
   NS_LOG_FUNCTION(this << address << position);
-  for(unsigned int i = 0; i < items.size(); i++)
+  uint32_t i = Probe (address);
+  if (IsFresh (i))
     {
-      if(items[i]->GetAddress() == address)
-	{
-	  *existsAddress = true;
-	  return Angles (items[i]->GetPosition (), position);
-	}
+      *existsAddress = true;
+      return Angles (m_items[i].GetPosition (), position);
     }
   *existsAddress = false;
   return Angles ((double)0, (double)0);
 }
+
+int
+GeographyTable::GetSector (Mac48Address address, const Vector &position, Ptr<WifiAntennaModel> antenna, bool *existsAddress)
+{
+  NS_LOG_FUNCTION (this << address << position);
+  uint32_t i = Probe (address);
+  if (!IsFresh (i))
+    {
+      *existsAddress = false;
+      return 0;
+    }
+  *existsAddress = true;
+  int sector;
+  int nModes = antenna->GetNAntennaModes ();
+  if (!m_items[i].GetSector (position, m_sectorUpdateDistance, nModes, &sector))
+    {
+      sector = antenna->GetNextAntennaMode (Angles (m_items[i].GetPosition (), position));
+      m_items[i].SetSector (position, nModes, sector);
+      NS_LOG_DEBUG ("resolved sector " << sector << " for " << address);
+    }
+  return sector;
+}
+
+bool
+GeographyTable::MustSendPosition (void)
+{
+  Time now = Simulator::Now ();
+  if (m_positionSent && now < m_lastPositionSent + m_positionInterval)
+    {
+      return false;
+    }
+  m_positionSent = true;
+  m_lastPositionSent = now;
+  return true;
+}
   
 void
 GeographyTable::AddItem(Mac48Address address, const Vector &position)
 {
   NS_LOG_FUNCTION(this << address << position);
-  items.push_back(new GeographyItem(address, position));
+  UpdateTable (address, position);
 }
   
 void
 GeographyTable::InitItem()
 {
-  items.clear();
+  m_items.assign (16, GeographyItem ());
+  m_used.assign (16, false);
+  m_nItems = 0;
 }
 bool
 GeographyTable::IsExistsAddress(Mac48Address address)
 {
   NS_LOG_FUNCTION(this);
-  for(unsigned int i = 0; i < items.size(); i++)
-    {
-      NS_LOG_DEBUG(this << items[i]->GetAddress());
-      if(items[i]->GetAddress() == address)
-	{
-	  return true;
-	}
-    }
-  return false;
+  return IsFresh (Probe (address));
 }
 void
 GeographyTable::UpdatePosition(Mac48Address address,  const Vector &position)
 {
   NS_LOG_FUNCTION(this);
-  for(unsigned int i = 0; i < items.size(); i++)
+  uint32_t i = Probe (address);
+  if (m_used[i])
     {
-      if(items[i]->GetAddress() == address)
-	{
-	  items[i]->SetPosition(position);
-	}
+      m_items[i].SetPosition (position);
     }
 }  
 void
@@ -108,30 +155,112 @@ GeographyTable::UpdateTable(Mac48Address address, const Vector &position)
 {
 
   NS_LOG_FUNCTION(this << address);
-  if(IsExistsAddress(address))
+  uint32_t i = Probe (address);
+  if (m_used[i])
     {
-      UpdatePosition(address, position);
+      m_items[i].SetPosition (position);
+      return;
     }
-  else
+  if (2 * (m_nItems + 1) > m_items.size ())
     {
-      AddItem(address, position);
+      Reserve ();
+      i = Probe (address);
     }
+  m_items[i] = GeographyItem (address, position);
+  m_used[i] = true;
+  m_nItems++;
 }
 
+uint32_t
+GeographyTable::GetNItems (void) const
+{
+  return m_nItems;
+}
 
-  
-GeographyItem::GeographyItem (Mac48Address address, const Vector &position)
-  : m_address (address),
-    m_position (position)
+uint32_t
+GeographyTable::Probe (Mac48Address address) const
+{
+  uint32_t mask = m_items.size () - 1;
+  uint32_t i = Mac48AddressHash (address) & mask;
+  while (m_used[i] && m_items[i].GetAddress () != address)
+    {
+      i = (i + 1) & mask;
+    }
+  return i;
+}
+
+bool
+GeographyTable::IsFresh (uint32_t slot) const
+{
+  if (!m_used[slot])
+    {
+      return false;
+    }
+  return m_maxAge.IsZero ()
+    || Simulator::Now () - m_items[slot].GetUpdateTime () <= m_maxAge;
+}
+
+void
+GeographyTable::Reserve (void)
+{
+  uint32_t capacity = m_items.size ();
+  if (!m_maxAge.IsZero ())
+    {
+      for (uint32_t i = 0; i < capacity; i++)
+        {
+          if (m_used[i] && !IsFresh (i))
+            {
+              NS_LOG_DEBUG ("drop stale position of " << m_items[i].GetAddress ());
+              m_used[i] = false;
+              m_nItems--;
+            }
+        }
+    }
+  // keep the load factor at most 1/2
+  while (2 * (m_nItems + 1) > capacity)
+    {
+      capacity *= 2;
+    }
+  Rehash (capacity);
+}
+
+void
+GeographyTable::Rehash (uint32_t capacity)
+{
+  std::vector<GeographyItem> items (capacity);
+  std::vector<bool> used (capacity, false);
+  items.swap (m_items);
+  used.swap (m_used);
+  for (uint32_t i = 0; i < items.size (); i++)
+    {
+      if (used[i])
+        {
+          uint32_t j = Probe (items[i].GetAddress ());
+          m_items[j] = items[i];
+          m_used[j] = true;
+        }
+    }
+}
+
+GeographyItem::GeographyItem ()
+  : m_hasSector (false),
+    m_sector (0),
+    m_sectorModes (0)
 {
 }
 
-GeographyItem::~GeographyItem ()
+GeographyItem::GeographyItem (Mac48Address address, const Vector &position)
+  : m_address (address),
+    m_position (position),
+    m_updateTime (Simulator::Now ()),
+    m_hasSector (false),
+    m_sector (0),
+    m_sectorModes (0)
 {
 }
 
 Mac48Address
-GeographyItem::GetAddress()
+GeographyItem::GetAddress() const
 {
   return m_address;
 }
@@ -140,12 +269,53 @@ void
 GeographyItem::SetPosition (const Vector &position)
 {
   m_position = position;
+  m_updateTime = Simulator::Now ();
 }
 
 Vector
-GeographyItem::GetPosition ()
+GeographyItem::GetPosition () const
 {
   return m_position;
 }
 
+Time
+GeographyItem::GetUpdateTime (void) const
+{
+  return m_updateTime;
+}
+
+static double
+SquaredDistance (const Vector &a, const Vector &b)
+{
+  double dx = a.x - b.x;
+  double dy = a.y - b.y;
+  double dz = a.z - b.z;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+bool
+GeographyItem::GetSector (const Vector &origin, double maxDistance, int nModes, int *sector) const
+{
+  double max2 = maxDistance * maxDistance;
+  if (!m_hasSector
+      || m_sectorModes != nModes
+      || SquaredDistance (m_position, m_sectorPosition) > max2
+      || SquaredDistance (origin, m_sectorOrigin) > max2)
+    {
+      return false;
+    }
+  *sector = m_sector;
+  return true;
+}
+
+void
+GeographyItem::SetSector (const Vector &origin, int nModes, int sector)
+{
+  m_hasSector = true;
+  m_sector = sector;
+  m_sectorModes = nModes;
+  m_sectorPosition = m_position;
+  m_sectorOrigin = origin;
+}
+
 } // namespace ns3
@@ -28,38 +28,123 @@
 #include "ns3/object.h"
 #include "ns3/vector.h"
 #include "ns3/angles.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
 
 namespace ns3 {
 
+class WifiAntennaModel;
+
+/**
+ * Last known position of a neighbour, and the antenna sector resolved
+ * from it.
+ */
 class GeographyItem
 {
 public:
-  ~GeographyItem();
+  GeographyItem ();
   GeographyItem (Mac48Address address, const Vector &position);
-  Mac48Address GetAddress (void);
+  Mac48Address GetAddress (void) const;
   void SetPosition (const Vector &position);
-  Vector GetPosition ();
+  Vector GetPosition () const;
+  /**
+   * \return the time of the last position update
+   */
+  Time GetUpdateTime (void) const;
+  /**
+   * \param origin own position
+   * \param maxDistance distance the positions may move before the
+   *        sector has to be resolved again
+   * \param nModes number of modes of the antenna now
+   * \param sector the cached sector, set if it is still valid
+   * \return true if the cached sector is still valid
+   */
+  bool GetSector (const Vector &origin, double maxDistance, int nModes, int *sector) const;
+  /**
+   * Cache the sector resolved from the current position.
+   *
+   * \param origin own position the sector was resolved from
+   * \param nModes number of modes of the antenna the sector was
+   *        resolved with
+   * \param sector antenna mode pointing at the neighbour
+   */
+  void SetSector (const Vector &origin, int nModes, int sector);
   
 private:
   Mac48Address m_address;
   Vector m_position;
+  Time m_updateTime;
+  bool m_hasSector;
+  int m_sector;
+  int m_sectorModes;        //!< number of antenna modes the sector was resolved with
+  Vector m_sectorPosition;  //!< neighbour position the sector was resolved from
+  Vector m_sectorOrigin;    //!< own position the sector was resolved from
 };
 
+/**
+ * Positions of the neighbours, kept by value in an open-addressing
+ * (linear probing) table keyed by address. The antenna sector pointing
+ * at each neighbour is cached next to its position and resolved again
+ * only when either end moved further than SectorUpdateDistance or the
+ * number of antenna sectors changed.
+ */
 class GeographyTable : public Object
 {
 public:
   static TypeId GetTypeId (void);
   Angles GetAngle(Mac48Address, const Vector &position, bool *existsAddress);
+  /**
+   * \param address the neighbour
+   * \param position own position
+   * \param antenna the antenna which resolves angles into sectors
+   * \param existsAddress set to false if the position of the neighbour
+   *        is not known
+   * \return the antenna mode pointing at the neighbour
+   */
+  int GetSector (Mac48Address address, const Vector &position, Ptr<WifiAntennaModel> antenna, bool *existsAddress);
+  /**
+   * Whether the own position is to be sent along with the next frame;
+   * it is sent at most once per PositionInterval. Every neighbour which
+   * decodes that frame learns the position, whatever its destination.
+   *
+   * \return true if the position must be sent now
+   */
+  bool MustSendPosition (void);
   void AddItem(Mac48Address address, const Vector &position);
   void InitItem();
   bool IsExistsAddress(Mac48Address address);
   void UpdatePosition(Mac48Address address, const Vector &position);
   void UpdateTable(Mac48Address address, const Vector &position);
+  /**
+   * \return the number of neighbours in the table
+   */
+  uint32_t GetNItems (void) const;
 
   GeographyTable();
   ~GeographyTable();
 private:
-  std::vector<GeographyItem*> items;
+  /**
+   * \return the slot holding the address, or the free slot where it belongs
+   */
+  uint32_t Probe (Mac48Address address) const;
+  /**
+   * \return true if the slot holds an entry younger than the maximum age
+   */
+  bool IsFresh (uint32_t slot) const;
+  /**
+   * Make room for one more entry, dropping the stale entries first.
+   */
+  void Reserve (void);
+  void Rehash (uint32_t capacity);
+
+  std::vector<GeographyItem> m_items; //!< power of two sized
+  std::vector<bool> m_used;           //!< whether each slot of m_items is used
+  uint32_t m_nItems;
+  Time m_maxAge;                      //!< 0 if entries never age
+  double m_sectorUpdateDistance;
+  Time m_positionInterval;            //!< 0 to send the position with every frame
+  Time m_lastPositionSent;
+  bool m_positionSent;
 };
 
 } // namespace ns3
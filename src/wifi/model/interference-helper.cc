@@ -20,9 +20,13 @@
 #include "interference-helper.h"
 #include "wifi-phy.h"
 #include "error-rate-model.h"
+#include "mac48-address-hash.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include <algorithm>
+#include <cmath>
+#include <new>
+#include <limits>
 
 NS_LOG_COMPONENT_DEFINE ("InterferenceHelper");
 
@@ -180,14 +184,175 @@ InterferenceHelper::NiChange::operator < (const InterferenceHelper::NiChange& o)
   return (m_time < o.m_time);
 }
 
+/****************************************************************
+ *       Recycled storage of the phy events
+ ****************************************************************/
+
+InterferenceHelper::EventPool::EventPool ()
+  : m_nAllocations (0),
+    m_nReuses (0)
+{
+}
+InterferenceHelper::EventPool::~EventPool ()
+{
+  for (std::vector<void *>::iterator i = m_free.begin (); i != m_free.end (); i++)
+    {
+      ::operator delete (*i);
+    }
+}
+void *
+InterferenceHelper::EventPool::Allocate (void)
+{
+  if (m_free.empty ())
+    {
+      m_nAllocations++;
+      return ::operator new (sizeof (Event));
+    }
+  m_nReuses++;
+  void *storage = m_free.back ();
+  m_free.pop_back ();
+  return storage;
+}
+void
+InterferenceHelper::EventPool::Release (void *storage)
+{
+  m_free.push_back (storage);
+}
+uint64_t
+InterferenceHelper::EventPool::GetNAllocations (void) const
+{
+  return m_nAllocations;
+}
+uint64_t
+InterferenceHelper::EventPool::GetNReuses (void) const
+{
+  return m_nReuses;
+}
+
+void
+InterferenceHelper::EventDeleter::Delete (Event *event)
+{
+  if (event->m_pool == 0)
+    {
+      delete event;
+      return;
+    }
+  // the event may hold the last reference to its pool
+  Ptr<EventPool> pool = event->m_pool;
+  event->~Event ();
+  pool->Release (event);
+}
+
+/****************************************************************
+ *       Address index of the last event of each transmitter
+ ****************************************************************/
+
+InterferenceHelper::EventTable::EventTable ()
+  : m_slots (16),
+    m_size (0)
+{
+}
+uint32_t
+InterferenceHelper::EventTable::Probe (Mac48Address address) const
+{
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t i = Mac48AddressHash (address) & mask;
+  while (m_slots[i] != 0 && m_slots[i]->GetAddress () != address)
+    {
+      i = (i + 1) & mask;
+    }
+  return i;
+}
+Ptr<InterferenceHelper::Event>
+InterferenceHelper::EventTable::Find (Mac48Address address) const
+{
+  return m_slots[Probe (address)];
+}
+void
+InterferenceHelper::EventTable::Insert (Ptr<Event> event)
+{
+  if (!HasRoom ())
+    {
+      Rehash (m_slots.size () * 2);
+    }
+  uint32_t i = Probe (event->GetAddress ());
+  NS_ASSERT (m_slots[i] == 0);
+  m_slots[i] = event;
+  m_size++;
+}
+uint32_t
+InterferenceHelper::EventTable::Evict (Time before)
+{
+  uint32_t evicted = 0;
+  for (std::vector<Ptr<Event> >::iterator i = m_slots.begin (); i != m_slots.end (); i++)
+    {
+      if (*i != 0 && (*i)->GetEndTime () < before)
+        {
+          *i = 0;
+          evicted++;
+        }
+    }
+  if (evicted > 0)
+    {
+      // removing entries breaks the probe chains, so reinsert the
+      // survivors, into a smaller table if it has become sparse
+      m_size -= evicted;
+      uint32_t capacity = m_slots.size ();
+      while (capacity > 16 && 8 * m_size < capacity)
+        {
+          capacity /= 2;
+        }
+      Rehash (capacity);
+    }
+  return evicted;
+}
+bool
+InterferenceHelper::EventTable::HasRoom (void) const
+{
+  // keep the load factor at most 1/2
+  return 2 * (m_size + 1) <= m_slots.size ();
+}
+uint32_t
+InterferenceHelper::EventTable::GetSize (void) const
+{
+  return m_size;
+}
+void
+InterferenceHelper::EventTable::Clear (void)
+{
+  m_slots.assign (16, Ptr<Event> ());
+  m_size = 0;
+}
+void
+InterferenceHelper::EventTable::Rehash (uint32_t capacity)
+{
+  std::vector<Ptr<Event> > old (capacity);
+  old.swap (m_slots);
+  for (std::vector<Ptr<Event> >::const_iterator i = old.begin (); i != old.end (); i++)
+    {
+      if (*i != 0)
+        {
+          m_slots[Probe ((*i)->GetAddress ())] = *i;
+        }
+    }
+}
+
 /****************************************************************
  *       The actual InterferenceHelper
  ****************************************************************/
 
 InterferenceHelper::InterferenceHelper ()
   : m_errorRateModel (0),
+    m_csrResolutionDb (0),
+    m_niSequence (0),
     m_firstPower (0.0),
-    m_rxing (false)
+    m_rxing (false),
+    m_prefixPower (0.0),
+    m_prefixValid (false),
+    m_eventLifetime (MilliSeconds (10)),
+    m_lastCompaction (Seconds (0)),
+    m_maxNEvents (0),
+    m_eventPool (Create<EventPool> ())
 {
 }
 InterferenceHelper::~InterferenceHelper ()
@@ -204,12 +369,15 @@ InterferenceHelper::Add (uint32_t size, WifiMode payloadMode,
 {
   Ptr<InterferenceHelper::Event> event;
 
-  event = Create<InterferenceHelper::Event> (size,
-                                             payloadMode,
-                                             preamble,
-                                             duration,
-                                             rxPowerW,
-                                             txVector);
+  event = Ptr<InterferenceHelper::Event> (new (m_eventPool->Allocate ())
+                                         InterferenceHelper::Event (size,
+                                                                    payloadMode,
+                                                                    preamble,
+                                                                    duration,
+                                                                    rxPowerW,
+                                                                    txVector),
+                                         false);
+  event->m_pool = m_eventPool;
   event->SetAddress(address);
   UpdateEvent (event);
   AppendEvent (event);
@@ -224,13 +392,16 @@ InterferenceHelper::Add (uint32_t size, WifiMode payloadMode,
                          Mac48Address address)
 {
   Ptr<InterferenceHelper::Event> event;
-  event = Create<InterferenceHelper::Event> (size,
-                                             payloadMode,
-                                             preamble,
-                                             startTime,
-                                             endTime,
-                                             rxPowerW,
-                                             txVector);
+  event = Ptr<InterferenceHelper::Event> (new (m_eventPool->Allocate ())
+                                         InterferenceHelper::Event (size,
+                                                                    payloadMode,
+                                                                    preamble,
+                                                                    startTime,
+                                                                    endTime,
+                                                                    rxPowerW,
+                                                                    txVector),
+                                         false);
+  event->m_pool = m_eventPool;
   event->SetAddress(address);
   NS_LOG_DEBUG("startTime " << startTime << " endTime " << endTime <<
                " rxPowerW " << rxPowerW << " address " << address);
@@ -241,40 +412,85 @@ InterferenceHelper::Add (uint32_t size, WifiMode payloadMode,
 void
 InterferenceHelper::UpdateEvent(Ptr<InterferenceHelper::Event> event){
   NS_LOG_FUNCTION(this);
-  int i = GetEventIndexByAddress (event->GetAddress());
-  if(i == -1)
+  Ptr<Event> stored = m_events.Find (event->GetAddress());
+  if(stored == 0)
     {
       NS_LOG_DEBUG("AddEvnet " << event->GetAddress());
       AddEvent(event);
     }
   else
     {
-      NS_LOG_DEBUG("Update Event[" << i << "]");
-      Events[i]->SetRxPowerW    (event->GetRxPowerW());
-      Events[i]->SetStartTime   (event->GetStartTime());
-      Events[i]->SetEndTime     (event->GetEndTime());
-      Events[i]->SetPayloadMode (event->GetPayloadMode());
-      Events[i]->SetPreambleType(event->GetPreambleType());
-      Events[i]->SetTxVector    (event->GetTxVector());
+      NS_LOG_DEBUG("Update Event " << event->GetAddress());
+      stored->SetRxPowerW    (event->GetRxPowerW());
+      stored->SetStartTime   (event->GetStartTime());
+      stored->SetEndTime     (event->GetEndTime());
+      stored->SetPayloadMode (event->GetPayloadMode());
+      stored->SetPreambleType(event->GetPreambleType());
+      stored->SetTxVector    (event->GetTxVector());
     }
 }
+
 void
 InterferenceHelper::AddEvent(Ptr<InterferenceHelper::Event> event){
   NS_LOG_FUNCTION(this);
-  Events.push_back(event);
+  if (!m_events.HasRoom ())
+    {
+      // forget the transmitters which have been silent for a while
+      // before making the table any larger
+      uint32_t evicted = m_events.Evict (Simulator::Now () - m_eventLifetime);
+      NS_LOG_DEBUG ("Evicted " << evicted << " expired events");
+    }
+  m_events.Insert (event);
+  m_maxNEvents = std::max (m_maxNEvents, m_events.GetSize ());
 }
 
-int
-InterferenceHelper::GetEventIndexByAddress (Mac48Address address){
-  NS_LOG_FUNCTION(this);
+Ptr<InterferenceHelper::Event>
+InterferenceHelper::GetEventByAddress (Mac48Address address) const
+{
+  return m_events.Find (address);
+}
+
+void
+InterferenceHelper::SetEventLifetime (Time lifetime)
+{
+  m_eventLifetime = lifetime;
+}
+
+Time
+InterferenceHelper::GetEventLifetime (void) const
+{
+  return m_eventLifetime;
+}
 
-  for(unsigned int i = 0; i < Events.size(); i++){
-    NS_LOG_DEBUG(this << Events[i]->GetAddress());
-    if(Events[i]->GetAddress() == address){
-      return i;
+void
+InterferenceHelper::CompactEvents (void)
+{
+  Time now = Simulator::Now ();
+  if (now < m_lastCompaction + m_eventLifetime)
+    {
+      return;
     }
-  }
-  return -1;
+  m_lastCompaction = now;
+  uint32_t evicted = m_events.Evict (now - m_eventLifetime);
+  NS_LOG_DEBUG ("Compacted " << evicted << " expired events, " << m_events.GetSize () << " left");
+}
+
+uint32_t
+InterferenceHelper::GetNEvents (void) const
+{
+  return m_events.GetSize ();
+}
+
+uint32_t
+InterferenceHelper::GetMaxNEvents (void) const
+{
+  return m_maxNEvents;
+}
+
+Ptr<const InterferenceHelper::EventPool>
+InterferenceHelper::GetEventPool (void) const
+{
+  return m_eventPool;
 }
 
 void
@@ -293,6 +509,7 @@ void
 InterferenceHelper::SetErrorRateModel (Ptr<ErrorRateModel> rate)
 {
   m_errorRateModel = rate;
+  m_csrCache.clear ();
 }
 
 Ptr<ErrorRateModel>
@@ -301,21 +518,44 @@ InterferenceHelper::GetErrorRateModel (void) const
   return m_errorRateModel;
 }
 
+void
+InterferenceHelper::SetChunkSuccessRateResolution (double resolutionDb)
+{
+  NS_ASSERT (resolutionDb >= 0);
+  m_csrResolutionDb = resolutionDb;
+  m_csrCache.clear ();
+}
+
+double
+InterferenceHelper::GetChunkSuccessRateResolution (void) const
+{
+  return m_csrResolutionDb;
+}
+
 Time
 InterferenceHelper::GetEnergyDuration (double energyW)
 {
   Time now = Simulator::Now ();
   double noiseInterferenceW  = 0.0;
   Time end = now;
-  noiseInterferenceW = m_firstPower;
-  for (NiChanges::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
+  // the changes before now only contribute to the power: take them from
+  // the running sum instead of rescanning them.
+  if (!m_prefixValid)
     {
-      noiseInterferenceW += i->GetDelta ();
-      end = i->GetTime ();
-      if (end < now)
-        {
-          continue;
-        }
+      m_prefixEnd = m_niChanges.begin ();
+      m_prefixPower = m_firstPower;
+      m_prefixValid = true;
+    }
+  while (m_prefixEnd != m_niChanges.end () && m_prefixEnd->first.first < now)
+    {
+      m_prefixPower += m_prefixEnd->second;
+      m_prefixEnd++;
+    }
+  noiseInterferenceW = m_prefixPower;
+  for (NiTimeline::const_iterator i = m_prefixEnd; i != m_niChanges.end (); i++)
+    {
+      noiseInterferenceW += i->second;
+      end = i->first.first;
       if (noiseInterferenceW < energyW)
         {
           break;
@@ -336,41 +576,35 @@ InterferenceHelper::ChangeEventEndTime(Mac48Address address, Time endTime)
 {
   NS_LOG_FUNCTION(this << "endTime " << endTime <<
                   " " << address);
-  int i = GetEventIndexByAddress (address);
-  if(i == -1)
+  Ptr<Event> event = m_events.Find (address);
+  if(event == 0)
     {
       NS_LOG_DEBUG("Does not manage address, ignore");
     }
   else
     {
       Time now = Simulator::Now();
-      if(now >= Events[i]->GetEndTime() )
+      if(now >= event->GetEndTime() )
         {
-          AddNiChangeEvent (NiChange (Events[i]->GetEndTime (), Events[i]->GetRxPowerW ()));
-          AddNiChangeEvent (NiChange (endTime, -Events[i]->GetRxPowerW ()));
-          Events[i]->SetEndTime(endTime);
+          AddNiChangeEvent (NiChange (event->GetEndTime (), event->GetRxPowerW ()));
+          AddNiChangeEvent (NiChange (endTime, -event->GetRxPowerW ()));
+          event->SetEndTime(endTime);
         }
     }
 }
   
+
 void
 InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
 {
   Time now = Simulator::Now ();
   if (!m_rxing)
     {
-      NiChanges::iterator nowIterator = GetPosition (now);
-      for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-        {
-          m_firstPower += i->GetDelta ();
-        }
-      m_niChanges.erase (m_niChanges.begin (), nowIterator);
-      m_niChanges.insert (m_niChanges.begin (), NiChange (event->GetStartTime (), event->GetRxPowerW ()));
-    }
-  else
-    {
-      AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+      FoldNiChanges (GetPosition (now));
     }
+  // after the fold, the remaining changes are later than the start of
+  // the event, so it is inserted at the front of the timeline.
+  AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
   AddNiChangeEvent (NiChange (event->GetEndTime (), -event->GetRxPowerW ()));
 
   NS_LOG_DEBUG("firstPower " << m_firstPower);
@@ -392,26 +626,16 @@ InterferenceHelper::AppendEventForFutureEvent (Ptr<InterferenceHelper::Event> ev
         {
           NS_LOG_DEBUG("firstPower " << m_firstPower);
           NS_LOG_DEBUG("[mark]");
-          NiChanges::iterator nowIterator = GetPosition (now);
-          for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-            {
-              NS_LOG_DEBUG("getdelta " << i->GetDelta ());
-              m_firstPower += i->GetDelta ();
-            }
-          m_niChanges.erase (m_niChanges.begin (), nowIterator);
-          m_niChanges.insert (m_niChanges.begin (), NiChange (event->GetStartTime (), event->GetRxPowerW ()));
-        }
-      else
-        {
-          AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+          FoldNiChanges (GetPosition (now));
         }
+      AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
       AddNiChangeEvent (NiChange (event->GetEndTime (), -event->GetRxPowerW ()));
     }
 
   NS_LOG_DEBUG("firstPower " << m_firstPower);
-  for (NiChanges::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
+  for (NiTimeline::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
     {
-      NS_LOG_DEBUG(" Time " << (*i).GetTime () << " DB " << (*i).GetDelta());
+      NS_LOG_DEBUG(" Time " << i->first.first << " DB " << i->second);
     }
 }
 
@@ -436,14 +660,16 @@ InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event>
   NS_LOG_DEBUG("firstPower " << m_firstPower);
   double noiseInterference = m_firstPower;
   NS_ASSERT (m_rxing);
-  for (NiChanges::const_iterator i = m_niChanges.begin () + 1; i != m_niChanges.end (); i++)
+  NS_ASSERT (!m_niChanges.empty ());
+  NiTimeline::const_iterator i = m_niChanges.begin ();
+  for (i++; i != m_niChanges.end (); i++)
     {
-      if ((event->GetEndTime () == i->GetTime ()) && event->GetRxPowerW () == -i->GetDelta ())
+      if ((event->GetEndTime () == i->first.first) && event->GetRxPowerW () == -i->second)
         {
           break;
         }
-      NS_LOG_DEBUG("CNIW time " << i->GetTime () << " pw " << i->GetDelta ());
-      ni->push_back (*i);
+      NS_LOG_DEBUG("CNIW time " << i->first.first << " pw " << i->second);
+      ni->push_back (NiChange (i->first.first, i->second));
     }
   ni->insert (ni->begin (), NiChange (event->GetStartTime (), noiseInterference));
   NS_LOG_DEBUG("FIRST CNIW time " << event->GetStartTime () << "end " << event->GetEndTime () <<" pw " << noiseInterference);
@@ -461,7 +687,30 @@ InterferenceHelper::CalculateChunkSuccessRate (double snir, Time duration, WifiM
     }
   uint32_t rate = mode.GetPhyRate ();
   uint64_t nbits = (uint64_t)(rate * duration.GetSeconds ());
-  double csr = m_errorRateModel->GetChunkSuccessRate (mode, snir, (uint32_t)nbits);
+  if (m_csrResolutionDb == 0 || snir <= 0)
+    {
+      return m_errorRateModel->GetChunkSuccessRate (mode, snir, (uint32_t)nbits);
+    }
+  double step = std::floor (10.0 * std::log10 (snir) / m_csrResolutionDb + 0.5);
+  std::pair<int32_t, uint32_t> key ((int32_t)step, (uint32_t)nbits);
+  if (m_csrCache.size () <= mode.GetUid ())
+    {
+      m_csrCache.resize (mode.GetUid () + 1);
+    }
+  ChunkSuccessRates &rates = m_csrCache[mode.GetUid ()];
+  ChunkSuccessRates::const_iterator i = rates.find (key);
+  if (i != rates.end ())
+    {
+      return i->second;
+    }
+  if (rates.size () >= 65536)
+    {
+      // the chunk lengths do not repeat, start over
+      rates.clear ();
+    }
+  double roundedSnir = std::pow (10.0, step * m_csrResolutionDb / 10.0);
+  double csr = m_errorRateModel->GetChunkSuccessRate (mode, roundedSnir, (uint32_t)nbits);
+  rates.insert (std::make_pair (key, csr));
   return csr;
 }
 
@@ -737,7 +986,7 @@ InterferenceHelper::CalculatePer (Ptr<const InterferenceHelper::Event> event, Ni
 
 
 double
-InterferenceHelper::CalculatePerPayload (Ptr<const InterferenceHelper::Event> event, NiChanges *ni, uint32_t busytoneSize) const
+InterferenceHelper::CalculatePerPayload (Ptr<const InterferenceHelper::Event> event, NiChanges *ni, Time busytoneDuration) const
 {
   NS_LOG_DEBUG("Now Time:" << Simulator::Now());
   for(NiChanges::iterator j = ni->begin (); ni->end () != j; j++){
@@ -747,11 +996,7 @@ InterferenceHelper::CalculatePerPayload (Ptr<const InterferenceHelper::Event> ev
   NiChanges::iterator j = ni->begin ();
   Time previous = (*j).GetTime ();
   WifiMode payloadMode = event->GetPayloadMode ();
-  Time busytoneDuration = Seconds(0);
-  if (busytoneSize != 0){
-    busytoneDuration = MicroSeconds (WifiPhy::GetPayloadDurationMicroSeconds (busytoneSize, event->GetTxVector()));
-  }
-  NS_LOG_DEBUG("busytoneSize" << busytoneSize << " duraiton " << busytoneDuration);
+  NS_LOG_DEBUG("busytoneDuration " << busytoneDuration);
 
   double powerW = event->GetRxPowerW ();
   double noiseInterferenceW = (*j).GetDelta ();
@@ -815,17 +1060,12 @@ InterferenceHelper::CalculateSnrPer (Ptr<InterferenceHelper::Event> event)
   NiChanges ni;
 
   Time start = event->GetStartTime();
-  NiChanges::iterator nowIterator = GetPosition (start);
+  NiTimeline::iterator nowIterator = GetPosition (start);
   if(m_niChanges.begin() != nowIterator)
     {
       nowIterator--;
     }
-  for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-    {
-      NS_LOG_DEBUG("start " << i->GetTime() << " GetDelta ()" << i->GetDelta ());
-      m_firstPower += i->GetDelta ();
-    }
-  m_niChanges.erase (m_niChanges.begin (), nowIterator);
+  FoldNiChanges (nowIterator);
 
   NS_LOG_DEBUG("firstPower " << m_firstPower);
   double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
@@ -845,21 +1085,16 @@ InterferenceHelper::CalculateSnrPer (Ptr<InterferenceHelper::Event> event)
 }
 
 struct InterferenceHelper::SnrPer
-InterferenceHelper::CalculateSnrPerPayload (Ptr<InterferenceHelper::Event> event, uint32_t busytoneSize)
+InterferenceHelper::CalculateSnrPerPayload (Ptr<InterferenceHelper::Event> event, Time busytoneDuration)
 {
   NiChanges ni;
   Time start = event->GetStartTime();
-  NiChanges::iterator nowIterator = GetPosition (start);
+  NiTimeline::iterator nowIterator = GetPosition (start);
   if(m_niChanges.begin() != nowIterator)
     {
       nowIterator--;
     }
-  for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-    {
-      NS_LOG_DEBUG("start " << i->GetTime() << " GetDelta ()" << i->GetDelta ());
-      m_firstPower += i->GetDelta ();
-    }
-  m_niChanges.erase (m_niChanges.begin (), nowIterator);
+  FoldNiChanges (nowIterator);
 
   NS_LOG_DEBUG("firstPower " << m_firstPower);
   double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
@@ -870,7 +1105,7 @@ InterferenceHelper::CalculateSnrPerPayload (Ptr<InterferenceHelper::Event> event
   /* calculate the SNIR at the start of the packet and accumulate
    * all SNIR changes in the snir vector.
    */
-  double per = CalculatePerPayload (event, &ni, busytoneSize);
+  double per = CalculatePerPayload (event, &ni, busytoneDuration);
 
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -884,17 +1119,40 @@ InterferenceHelper::EraseEvents (void)
   m_niChanges.clear ();
   m_rxing = false;
   m_firstPower = 0.0;
+  m_prefixValid = false;
 }
-InterferenceHelper::NiChanges::iterator
+InterferenceHelper::NiTimeline::iterator
 InterferenceHelper::GetPosition (Time moment)
 {
-  return std::upper_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (moment, 0));
+  return m_niChanges.upper_bound (NiKey (moment, std::numeric_limits<uint64_t>::max ()));
 
 }
 void
+InterferenceHelper::FoldNiChanges (NiTimeline::iterator position)
+{
+  for (NiTimeline::iterator i = m_niChanges.begin (); i != position; i++)
+    {
+      NS_LOG_DEBUG("start " << i->first.first << " GetDelta ()" << i->second);
+      m_firstPower += i->second;
+      if (m_prefixValid && i == m_prefixEnd)
+        {
+          // the running sum covers less than what is folded
+          m_prefixValid = false;
+        }
+    }
+  m_niChanges.erase (m_niChanges.begin (), position);
+}
+void
 InterferenceHelper::AddNiChangeEvent (NiChange change)
 {
-  m_niChanges.insert (GetPosition (change.GetTime ()), change);
+  NiKey key (change.GetTime (), m_niSequence++);
+  if (m_prefixValid
+      && (m_prefixEnd == m_niChanges.end () || key < m_prefixEnd->first))
+    {
+      // inserted before the end of the running sum
+      m_prefixValid = false;
+    }
+  m_niChanges.insert (std::make_pair (key, change.GetDelta ()));
 }
 void
 InterferenceHelper::NotifyRxStart ()
@@ -905,5 +1163,6 @@ void
 InterferenceHelper::NotifyRxEnd ()
 {
   m_rxing = false;
+  CompactEvents ();
 }
 } // namespace ns3
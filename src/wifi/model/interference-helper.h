@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <vector>
 #include <list>
+#include <map>
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
 #include "wifi-phy-standard.h"
@@ -42,11 +43,52 @@ class ErrorRateModel;
 class InterferenceHelper
 {
 public:
+  class Event;
+  /**
+   * Free list of Event storage. Each InterferenceHelper owns one, and
+   * every event it creates keeps a reference to it, so the storage of
+   * an event is recycled once the last reference to the event is gone.
+   */
+  class EventPool : public SimpleRefCount<InterferenceHelper::EventPool>
+  {
+public:
+    EventPool ();
+    ~EventPool ();
+    /**
+     * \return storage for one Event, recycled if possible
+     */
+    void * Allocate (void);
+    /**
+     * \param storage the storage of a destroyed Event
+     */
+    void Release (void *storage);
+    /**
+     * \return the number of Event storages taken from the heap
+     */
+    uint64_t GetNAllocations (void) const;
+    /**
+     * \return the number of Event storages recycled from the free list
+     */
+    uint64_t GetNReuses (void) const;
+private:
+    std::vector<void *> m_free;
+    uint64_t m_nAllocations;
+    uint64_t m_nReuses;
+  };
+  /**
+   * Deleter of Event: hands pooled storage back to its pool.
+   */
+  struct EventDeleter
+  {
+    static void Delete (Event *event);
+  };
   /**
    * Signal event for a packet.
    */
-  class Event : public SimpleRefCount<InterferenceHelper::Event>
+  class Event : public SimpleRefCount<InterferenceHelper::Event, empty, InterferenceHelper::EventDeleter>
   {
+    friend struct InterferenceHelper::EventDeleter;
+    friend class InterferenceHelper;
 public:
     /**
      * Create an Event with the given parameters.
@@ -148,6 +190,7 @@ private:
     double m_rxPowerW;
     WifiTxVector m_txVector;
     Mac48Address m_address;
+    Ptr<EventPool> m_pool; //!< pool of the storage, 0 if from the heap
   };
   /**
    * A struct for both SNR and PER
@@ -166,7 +209,39 @@ private:
   void ChangeEventEndTime(Mac48Address address, Time endTime);
   void UpdateEvent(Ptr<InterferenceHelper::Event> event);
   void AddEvent(Ptr<InterferenceHelper::Event> event);
-  int GetEventIndexByAddress (Mac48Address address);
+  /**
+   * \param address the transmitter address
+   * \return the last event received from the address, or 0 if none
+   */
+  Ptr<InterferenceHelper::Event> GetEventByAddress (Mac48Address address) const;
+  /**
+   * Events which ended more than this time ago may be forgotten when
+   * the address index runs out of room.
+   *
+   * \param lifetime the event lifetime
+   */
+  void SetEventLifetime (Time lifetime);
+  /**
+   * \return the event lifetime
+   */
+  Time GetEventLifetime (void) const;
+  /**
+   * Forget the events which ended more than the event lifetime ago.
+   * Runs at most once per event lifetime; called from NotifyRxEnd.
+   */
+  void CompactEvents (void);
+  /**
+   * \return the number of events currently indexed by address
+   */
+  uint32_t GetNEvents (void) const;
+  /**
+   * \return the largest number of events ever indexed by address
+   */
+  uint32_t GetMaxNEvents (void) const;
+  /**
+   * \return the pool the events of this helper are allocated from
+   */
+  Ptr<const EventPool> GetEventPool (void) const;
   
   /**
    * Set the noise figure.
@@ -193,6 +268,23 @@ private:
    * \return Error rate model
    */
   Ptr<ErrorRateModel> GetErrorRateModel (void) const;
+  /**
+   * Set the SNIR resolution of the chunk success rate cache.
+   *
+   * With a resolution of r dB, the success rate of a chunk is evaluated
+   * at the SNIR rounded to the nearest multiple of r dB, and memoized
+   * per WifiMode, rounded SNIR and number of bits. The result is thus
+   * the exact success rate at an SNIR within r/2 dB of the actual one;
+   * as the success rate grows with the SNIR, it lies between the exact
+   * rates at SNIR - r/2 dB and SNIR + r/2 dB.
+   *
+   * \param resolutionDb the SNIR resolution (dB), 0 to disable the cache
+   */
+  void SetChunkSuccessRateResolution (double resolutionDb);
+  /**
+   * \return the SNIR resolution (dB) of the chunk success rate cache
+   */
+  double GetChunkSuccessRateResolution (void) const;
 
 
   /**
@@ -235,7 +327,7 @@ private:
    * \return struct of SNR and PER
    */
   struct InterferenceHelper::SnrPer CalculateSnrPer (Ptr<InterferenceHelper::Event> event);
-  struct InterferenceHelper::SnrPer CalculateSnrPerPayload (Ptr<InterferenceHelper::Event> event, uint32_t busytoneSize);
+  struct InterferenceHelper::SnrPer CalculateSnrPerPayload (Ptr<InterferenceHelper::Event> event, Time busytoneDuration);
 
 
   /**
@@ -292,10 +384,64 @@ private:
    */
   typedef std::vector <NiChange> NiChanges;
   /**
-   * typedef for a list of Events
+   * Key of the NI timeline: the time of the change and an insertion
+   * counter, so that changes at the same time keep their insertion order.
+   */
+  typedef std::pair<Time, uint64_t> NiKey;
+  /**
+   * typedef for the NI timeline, i.e. the power deltas ordered by time
    */
-  //  typedef std::list<Ptr<Event> > Events;
-  std::vector<Ptr<Event> > Events;
+  typedef std::map<NiKey, double> NiTimeline;
+  /**
+   * Open-addressing (linear probing) hash table of the last event
+   * received from each transmitter, keyed by the 48-bit address.
+   */
+  class EventTable
+  {
+public:
+    EventTable ();
+    /**
+     * \param address the transmitter address
+     * \return the event of the address, or 0 if none
+     */
+    Ptr<Event> Find (Mac48Address address) const;
+    /**
+     * Insert an event whose address is not in the table yet.
+     *
+     * \param event the event
+     */
+    void Insert (Ptr<Event> event);
+    /**
+     * Remove the events which ended before the given time.
+     *
+     * \param before the expiry time
+     * \return the number of removed events
+     */
+    uint32_t Evict (Time before);
+    /**
+     * \return true if one more event can be inserted without growing
+     */
+    bool HasRoom (void) const;
+    /**
+     * \return the number of events in the table
+     */
+    uint32_t GetSize (void) const;
+    void Clear (void);
+private:
+    /**
+     * \return the slot holding the address, or the empty slot where it belongs
+     */
+    uint32_t Probe (Mac48Address address) const;
+    void Rehash (uint32_t capacity);
+
+    std::vector<Ptr<Event> > m_slots; //!< power of two sized, 0 if empty
+    uint32_t m_size;
+  };
+  EventTable m_events;
+  Time m_eventLifetime;
+  Time m_lastCompaction; //!< time of the last CompactEvents pass
+  uint32_t m_maxNEvents; //!< high-water mark of m_events
+  Ptr<EventPool> m_eventPool;
 
   //InterferenceHelper (const InterferenceHelper &o);
   //InterferenceHelper &operator = (const InterferenceHelper &o);
@@ -343,16 +489,40 @@ private:
    * \return the error rate of the packet
    */
   double CalculatePer (Ptr<const Event> event, NiChanges *ni) const;
-  double CalculatePerPayload (Ptr<const InterferenceHelper::Event> event, NiChanges *ni, uint32_t busytoneSize) const;
+  double CalculatePerPayload (Ptr<const InterferenceHelper::Event> event, NiChanges *ni, Time busytoneDuration) const;
 
-  double m_noiseFigure; /**< noise figure (linear) */
+  /**
+   * Chunk success rates of one WifiMode, keyed by the rounded SNIR
+   * (in multiples of the resolution) and the number of bits.
+   */
+  typedef std::map<std::pair<int32_t, uint32_t>, double> ChunkSuccessRates;
+
+    double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel;
+  double m_csrResolutionDb; //!< SNIR resolution of m_csrCache, 0 if disabled
+  mutable std::vector<ChunkSuccessRates> m_csrCache; //!< indexed by WifiMode uid
   /// Experimental: needed for energy duration calculation
-  NiChanges m_niChanges;
+  NiTimeline m_niChanges;
+  uint64_t m_niSequence; //!< insertion counter of m_niChanges
   double m_firstPower;
   bool m_rxing;
+  /**
+   * Running sum of m_firstPower and of the deltas before m_prefixEnd,
+   * accumulated in timeline order so that it is bit-identical to a
+   * rescan. Invalidated when a change is inserted before m_prefixEnd.
+   */
+  NiTimeline::iterator m_prefixEnd;
+  double m_prefixPower;
+  bool m_prefixValid;
   /// Returns an iterator to the first nichange, which is later than moment
-  NiChanges::iterator GetPosition (Time moment);
+  NiTimeline::iterator GetPosition (Time moment);
+  /**
+   * Fold the deltas before the given position into m_firstPower and
+   * erase them from the timeline.
+   *
+   * \param position
+   */
+  void FoldNiChanges (NiTimeline::iterator position);
   /**
    * Add NiChange to the list at the appropriate position.
    *
@@ -28,7 +28,6 @@
 #include "ns3/node.h"
 #include "ns3/double.h"
 #include "ns3/geography-table.h"
-#include "ns3/geography-tag.h"
 #include "ns3/angles.h"
 #include "ns3/mobility-model.h"
 #include "ns3/wifi-switched-beam-antenna-model.h"
@@ -37,9 +36,6 @@
 #include "wifi-phy.h"
 #include "wifi-mac-trailer.h"
 #include "surrounding-node-table.h"
-#include "busytone-tag.h"
-#include "secondary-tag.h"
-#include "source-tag.h"
 #include "qos-utils.h"
 #include "edca-txop-n.h"
 #include "snr-tag.h"
@@ -463,6 +459,13 @@ MacLow::GetSurroundingNodeTable()
   return m_surroundingNodeTable;
 }
 
+int64_t
+MacLow::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  return m_surroundingNodeTable->AssignStreams (stream);
+}
+
 void
 MacLow::SetWifiRemoteStationManager (Ptr<WifiRemoteStationManager> manager)
 {
@@ -655,6 +658,21 @@ MacLow::StartTransmission (Ptr<const Packet> packet,
   NS_ASSERT (m_phy->IsStateTx ());
 }
 
+Time
+MacLow::GetSecondaryRemainingTime (Ptr<const Packet> packet, const WifiMacHeader *hdr) const
+{
+  WifiTxVector dataTxVector = GetDataTxVector (packet, hdr);
+  WifiPreamble preamble;
+  if (m_phy->GetGreenfield () && m_stationManager->GetGreenfieldSupported (hdr->GetAddr1 ()))
+    preamble= WIFI_PREAMBLE_HT_GF;
+  else if (dataTxVector.GetMode().GetModulationClass () == WIFI_MOD_CLASS_HT)
+    preamble= WIFI_PREAMBLE_HT_MF;
+  else
+    preamble=WIFI_PREAMBLE_LONG;
+  Time secondaryEndTime = Simulator::Now () + m_phy->CalculateTxDuration (GetSize (packet, hdr), dataTxVector, preamble);
+  return m_phy->GetPrimaryTransmissionEndTime () - secondaryEndTime;
+}
+
 void
 MacLow::StartSecondaryTransmission (Ptr<const Packet> packet,
                            const WifiMacHeader* hdr,
@@ -731,34 +749,20 @@ MacLow::ReceiveOk (Ptr<Packet> packet, double rxSnr, WifiMode txMode, WifiPreamb
   packet->RemoveHeader (hdr);
 
   // AOA (Angle of arrival)
-  GeographyTag geoTag;
-  bool flgGeoTag = packet->RemovePacketTag (geoTag);
-  if (flgGeoTag && hdr.GetAddr1 () == m_self){
-    if (hdr.IsRts ()){
-      m_phy->GetGeographyTable ()->UpdateTable (hdr.GetAddr2 (), geoTag.Get ());
-    }else if (hdr.IsCts ()){
-      if (!m_currentHdr.GetAddr1 ().IsBroadcast ()){
-        m_phy->GetGeographyTable ()->UpdateTable (m_currentHdr.GetAddr1 (), geoTag.Get ());
-      }
-    }else if (hdr.IsAck ()){
-      if (!m_currentHdr.GetAddr1 ().IsBroadcast ()){
-        m_phy->GetGeographyTable ()->UpdateTable (m_currentHdr.GetAddr1 (), geoTag.Get ());
-      }
-    }else{
-      if (!hdr.GetAddr2 ().IsBroadcast ()){
-        m_phy->GetGeographyTable ()->UpdateTable (hdr.GetAddr2 (), geoTag.Get ());
-      }
-    }
+  // The position is only sent once per PositionInterval, so it is
+  // learnt from every decoded frame, overheard ones included; the
+  // metadata names the sender even for the frames without Addr2.
+  FdTxMetadata rxMetadata = m_phy->GetReceivingMetadata ();
+  if (rxMetadata.hasPosition && rxMetadata.source != m_self
+      && !rxMetadata.source.IsBroadcast ()){
+    m_phy->GetGeographyTable ()->UpdateTable (rxMetadata.source, rxMetadata.position);
   }
 
-  SourceTag sourceTag;
-  packet->RemovePacketTag (sourceTag);
-
   // update surrounding node table
   Mac48Address addr1 = hdr.GetAddr1();
   Mac48Address addr2 = hdr.GetAddr2();
   static Mac48Address networkAddress = Mac48Address ("00:00:00:00:00:00");
-  if(hdr.GetType() == WIFI_MAC_DATA &&
+  if(hdr.IsData () &&
      !addr1.IsBroadcast() &&
      !addr2.IsBroadcast() && addr2 != networkAddress )
     {
@@ -769,6 +773,7 @@ MacLow::ReceiveOk (Ptr<Packet> packet, double rxSnr, WifiMode txMode, WifiPreamb
           nextHop = false;
         }
       GetSurroundingNodeTable()->UpdateTable(addr2, nextHop, hasFrames);
+      GetSurroundingNodeTable()->UpdateLinkQuality(addr2, rxSnr);
       NS_LOG_INFO(this << "nextHop=" << nextHop << " hasFrames=" << hasFrames);
     }
   
@@ -859,6 +864,7 @@ MacLow::ReceiveOk (Ptr<Packet> packet, double rxSnr, WifiMode txMode, WifiPreamb
           bool hasFrames = hdr.IsMoreData();
           bool nextHop = true;
           GetSurroundingNodeTable()->UpdateTable(m_destinationAddress, nextHop, hasFrames);
+          GetSurroundingNodeTable()->UpdateLinkQuality(m_destinationAddress, rxSnr);
           NS_LOG_INFO(this << "receive ACK nextHop=" << nextHop << " hasFrames=" << hasFrames);
           m_listener->GotAck (rxSnr, txMode);
         }
@@ -1354,9 +1360,6 @@ MacLow::ForwardDown (Ptr<const Packet> packet, const WifiMacHeader* hdr,
                      WifiTxVector txVector, WifiPreamble preamble)
 {
   NS_LOG_FUNCTION (this << packet << hdr << txVector);
-  SourceTag sourceTag;
-  sourceTag.SetAddress (m_self);
-  packet->AddPacketTag (sourceTag);
   NS_LOG_DEBUG ("send " << hdr->GetTypeString () <<
                 ", to=" << hdr->GetAddr1 () <<
                 ", size=" << packet->GetSize () <<
@@ -1364,15 +1367,21 @@ MacLow::ForwardDown (Ptr<const Packet> packet, const WifiMacHeader* hdr,
                 ", duration=" << hdr->GetDuration () <<
                 ", seq=0x" << std::hex << m_currentHdr.GetSequenceControl () << std::dec);
 
-  // [2014/09/07 add sugiyama]  GeographyTag geoTag;
-  Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
-  Vector v = mobility->GetPosition ();
-  GeographyTag geoTag;
-  geoTag.Set (v);
-  packet->AddPacketTag (geoTag);
-  // [2014/09/07 end sugiyama]
+  // the receivers learn the source and the position of the sender
+  // from the metadata sent along with the frame; the position is only
+  // sent as often as the geography table asks for it, and every
+  // neighbour which decodes the frame learns it
+  FdTxMetadata metadata = m_txMetadata;
+  m_txMetadata = FdTxMetadata ();
+  metadata.source = m_self;
+  if (m_phy->GetGeographyTable ()->MustSendPosition ())
+    {
+      Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
+      metadata.position = mobility->GetPosition ();
+      metadata.hasPosition = true;
+    }
 
-  m_phy->SendPacket (packet, txVector.GetMode(), preamble, txVector);
+  m_phy->SendPacket (packet, txVector.GetMode(), preamble, txVector, metadata);
 }
 
 void
@@ -1593,15 +1602,8 @@ MacLow::StartSecondaryDataTxTimers (WifiTxVector dataTxVector)
   else
     preamble=WIFI_PREAMBLE_LONG;
 
-  BusytoneTag busytone;
-  bool flgBusytone = ConstCast<Packet>(m_currentPacket)->PeekPacketTag (busytone);
-  uint32_t busytoneSize = 0;
-  if(flgBusytone)
-    {
-      busytoneSize = busytone.GetDataSize();
-    }
-
-  Time txDuration = m_phy->CalculateTxDuration (GetSize (m_currentPacket, &m_currentHdr) + busytoneSize, dataTxVector, preamble);
+  Time txDuration = m_phy->CalculateTxDuration (GetSize (m_currentPacket, &m_currentHdr), dataTxVector, preamble)
+    + m_txMetadata.busytoneDuration;
   if (m_txParams.MustWaitNormalAck ())
     {
       Time timerDelay = txDuration + GetAckTimeout ();
@@ -1716,15 +1718,8 @@ MacLow::SendSecondaryDataPacket (void)
 
   // compare primaryEndTime with secondaryEndTime
   Time primaryEndTime = m_phy->GetPrimaryTransmissionEndTime();
-  Time secondaryEndDuration = m_phy->CalculateTxDuration(m_currentPacket->GetSize() +
-                                                         m_currentHdr.GetSize(),
-                                                         dataTxVector,
-                                                         preamble
-                                                     );
-
-
-  Time secondaryEndTime = secondaryEndDuration + Simulator::Now();
-  uint32_t busytoneSize = 0;
+  Time secondaryEndTime = primaryEndTime - GetSecondaryRemainingTime (m_currentPacket, &m_currentHdr);
+  Time busytoneDuration = Seconds (0);
   NS_LOG_DEBUG("primary=" << primaryEndTime << " secondary=" << secondaryEndTime);
   // 10000ns ignore
   if(primaryEndTime > secondaryEndTime + MicroSeconds(10))
@@ -1732,21 +1727,16 @@ MacLow::SendSecondaryDataPacket (void)
       NS_LOG_INFO("primaryEndtime > secondaryEndtime");
       Time timeOffset = primaryEndTime - secondaryEndTime;
       NS_ASSERT(timeOffset >= MicroSeconds(0));
-      busytoneSize = m_phy->GetPacketSizeFromDuration (timeOffset, dataTxVector);
+      busytoneDuration = m_phy->GetBusytoneDuration (timeOffset, dataTxVector);
     }
 
-  BusytoneTag busytone;
-  busytone.SetDataSize (busytoneSize);
-  m_currentPacket->AddPacketTag (busytone);
-  
-  // Set Secondary
-  SecondaryTag secondary;
-  secondary.SetDataSize (0);
-  m_currentPacket->AddPacketTag (secondary);
+  // Set busytone and secondary, sent along with the frame by ForwardDown
+  m_txMetadata.busytoneDuration = busytoneDuration;
+  m_txMetadata.secondary = true;
 
   StartSecondaryDataTxTimers (dataTxVector);
 
-  if(m_currentHdr.GetType () == WIFI_MAC_DATA)
+  if(m_currentHdr.IsData ())
     {
       NS_LOG_DEBUG(m_phy->GetReceivingAddress4());
       Mac48Address secondaryAddress = m_phy->GetReceivingAddress4();
@@ -1768,19 +1758,7 @@ MacLow::SendSecondaryDataPacket (void)
   m_currentPacket->AddTrailer (fcs);
 
   // set antenna mode
-  if(m_currentHdr.GetAddr1().IsBroadcast()){
-    SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
-  }else{
-    bool existsAddress = false;
-    Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
-    Vector v = mobility->GetPosition ();
-    Angles bet = m_phy->GetGeographyTable ()->GetAngle (m_currentHdr.GetAddr1(), v, &existsAddress);
-    if(existsAddress){
-      SetAntennaMode (bet);
-    }else{
-      SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
-    }
-  }
+  SetAntennaModeFor (m_currentHdr.GetAddr1 ());
 
   ForwardDown (m_currentPacket, &m_currentHdr, dataTxVector,preamble);
   m_currentPacket = 0;
@@ -1841,7 +1819,7 @@ MacLow::SendDataPacket (void)
   /* [add] 20140612 Address4, More Dataの変更  */
   Mac48Address addr4 = m_surroundingNodeTable->SelectSecondaryTransmissionNode();
 
-  if(m_currentHdr.GetType () == WIFI_MAC_DATA)
+  if(m_currentHdr.IsData ())
     {
       m_currentHdr.SetAddr4(addr4);
     }
@@ -1866,19 +1844,7 @@ MacLow::SendDataPacket (void)
   m_currentPacket->AddTrailer (fcs);
 
   // set antenna mode
-  if(m_currentHdr.GetAddr1().IsBroadcast()){
-    SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
-  }else{
-    bool existsAddress = false;
-    Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
-    Vector v = mobility->GetPosition ();
-    Angles bet = m_phy->GetGeographyTable ()->GetAngle (m_currentHdr.GetAddr1(), v, &existsAddress);
-    if(existsAddress){
-      SetAntennaMode (bet);
-    }else{
-      SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
-    }
-  }
+  SetAntennaModeFor (m_currentHdr.GetAddr1 ());
 
   ForwardDown (m_currentPacket, &m_currentHdr, dataTxVector,preamble);
   m_currentPacket = 0;
@@ -2140,19 +2106,7 @@ MacLow::SendAckAfterData (Mac48Address source, Time duration, WifiMode dataTxMod
     preamble=WIFI_PREAMBLE_LONG;
 
   // set antenna mode
-  if(source.IsBroadcast()){
-    SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
-  }else{
-    bool existsAddress = false;
-    Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
-    Vector v = mobility->GetPosition ();
-    Angles bet = m_phy->GetGeographyTable ()->GetAngle (source, v, &existsAddress);
-    if(existsAddress){
-      SetAntennaMode (bet);
-    }else{
-      SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
-    }
-  }
+  SetAntennaModeFor (source);
 
   ForwardDown (packet, &ack, ackTxVector, preamble);
 }
@@ -2494,4 +2448,19 @@ MacLow::SetAntennaMode (Angles bet)
   NS_LOG_FUNCTION (this << bet);
   m_phy->GetAntenna ()->SetAntennaMode (bet);
 }
+void
+MacLow::SetAntennaModeFor (Mac48Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+  if (address.IsBroadcast ())
+    {
+      SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
+      return;
+    }
+  bool existsAddress = false;
+  Ptr<MobilityModel> mobility = m_phy->GetMobility ()->GetObject<MobilityModel> ();
+  int sector = m_phy->GetGeographyTable ()->GetSector (address, mobility->GetPosition (),
+                                                       m_phy->GetAntenna (), &existsAddress);
+  SetAntennaMode (existsAddress ? sector : (int)WifiSwitchedBeamAntennaModel::OMNI);
+}
 } // namespace ns3
@@ -45,6 +45,7 @@
 #include "qos-utils.h"
 #include "block-ack-cache.h"
 #include "wifi-tx-vector.h"
+#include "fd-tx-metadata.h"
 
 namespace ns3 {
 
@@ -426,13 +427,39 @@ public:
                           const WifiMacHeader* hdr,
                           MacLowTransmissionParameters parameters,
                           MacLowTransmissionListener *listener);
+  /**
+   * \param packet the secondary frame, without header and trailer
+   * \param hdr its header
+   * \return the time between the end of the secondary frame sent now and
+   *         the end of the primary transmission; negative if the frame
+   *         would end after it
+   */
+  Time GetSecondaryRemainingTime (Ptr<const Packet> packet, const WifiMacHeader *hdr) const;
   Ptr<SurroundingNodeTable> GetSurroundingNodeTable ();
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
   /**
    * Set up WifiPhy associated with this MacLow.
    *
    * \param phy WifiPhy associated with this MacLow
    */
   void SetPhy (Ptr<WifiPhy> phy);
+  /**
+   * \param dcaTxop the DCF queue of the device, which serves the
+   *        secondary (full-duplex) transmissions and the busytones
+   *
+   * Only this queue takes part in full duplex. The EdcaTxopN queues of
+   * a QoS MAC are not registered here and have no secondary
+   * transmission entry points: QoS traffic is only sent as primary
+   * transmissions.
+   */
   void SetDcaTxop (Ptr<DcaTxop> dcaTxop);
   /**
    * Set up WifiRemoteStationManager associated with this MacLow.
@@ -599,6 +626,14 @@ public:
   void RegisterDcfListener (MacLowDcfListener *listener);
   void SetAntennaMode (int mode);
   void SetAntennaMode (Angles bet);
+  /**
+   * Point the antenna at a neighbour, using the sector cached in the
+   * geography table, or switch it to omni if the neighbour is unknown
+   * or the address is broadcast.
+   *
+   * \param address the neighbour
+   */
+  void SetAntennaModeFor (Mac48Address address);
 
   /**
    * \param packet to send (does not include the 802.11 MAC header and checksum)
@@ -692,6 +727,9 @@ public:
   void RegisterBlockAckListenerForAc (enum AcIndex ac, MacLowBlockAckEventListener *listener);
   virtual WifiTxVector GetDataTxVector (Ptr<const Packet> packet, const WifiMacHeader *hdr) const;
 
+  /**
+   * \return the queue set by SetDcaTxop
+   */
   Ptr<DcaTxop> GetDcaTxop ();
 
 
@@ -1119,6 +1157,7 @@ private:
 
   Ptr<Packet> m_currentPacket;              //!< Current packet transmitted/to be transmitted
   WifiMacHeader m_currentHdr;               //!< Header of the current packet
+  FdTxMetadata m_txMetadata;                //!< Full-duplex metadata of the next frame sent by ForwardDown
   MacLowTransmissionParameters m_txParams;  //!< Transmission parameters of the current packet
   MacLowTransmissionListener *m_listener;   //!< Transmission listener for the current packet
   Mac48Address m_self;                      //!< Address of this MacLow (Mac48Address)
@@ -0,0 +1,54 @@
+/* -*- Mode:C++; -*- */
+/*
+ * Copyright (c) 2014 Yusuke Sugiyama
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., Saruwatari Lab, Shizuoka University, Japan
+ *
+ * Author: Yusuke Sugiyama <sugiyama@aurum.cs.inf.shizuoka.ac.jp>
+ */
+
+#ifndef MAC48_ADDRESS_HASH_H
+#define MAC48_ADDRESS_HASH_H
+
+#include <stdint.h>
+#include "ns3/mac48-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * Hash of a 48-bit address for the open-addressing tables of the wifi
+ * module. The address bits are spread with Fibonacci hashing, so that
+ * consecutively allocated addresses do not land in adjacent slots.
+ *
+ * \param address the address
+ * \return the hash; mask its low bits for a power of two sized table
+ */
+inline uint32_t
+Mac48AddressHash (Mac48Address address)
+{
+  uint8_t buffer[6];
+  address.CopyTo (buffer);
+  uint64_t key = 0;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      key = (key << 8) | buffer[i];
+    }
+  return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+} // namespace ns3
+
+#endif /* MAC48_ADDRESS_HASH_H */
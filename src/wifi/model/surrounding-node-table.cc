@@ -24,68 +24,66 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/mac48-address.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "mac48-address-hash.h"
 
-// NS_OBJECT_ENSURE_REGISTERED (SurroundingNodeTable);
 NS_LOG_COMPONENT_DEFINE ("SurroundingNodeTable");
 
 namespace ns3 {
 
+NS_OBJECT_ENSURE_REGISTERED (SurroundingNodeTable)
+  ;
+
 TypeId
 SurroundingNodeTable::GetTypeId (void)
 {
   static TypeId tid = TypeId ("SurroundingNodeTable")
     .SetParent<Object> ()
     .AddConstructor<SurroundingNodeTable> ()
+    .AddAttribute ("WeightedSelection",
+                   "If true, the secondary transmission node is drawn within its "
+                   "priority class with a probability proportional to the SNR of "
+                   "the last frame received from it; otherwise uniformly.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SurroundingNodeTable::m_weighted),
+                   MakeBooleanChecker ())
     ;
   return tid;
 }
 
+const uint32_t SurroundingNodeTable::NO_ITEM;
+
 SurroundingNodeTable::SurroundingNodeTable ()
+  : m_weighted (false)
 {
   m_random = CreateObject<UniformRandomVariable> ();
+  InitItem();
 }
 
 SurroundingNodeTable::~SurroundingNodeTable ()
 {
-  InitItem();
 }
 
 Mac48Address
 SurroundingNodeTable::SelectSecondaryTransmissionNode()
 {
   NS_LOG_FUNCTION(this);
-  std::vector<uint32_t> ItemPriorities[4];
-  for(uint32_t i = 0; i < Items.size(); i++){
-    NS_LOG_DEBUG ("address:"   << Items[i]->GetAddress() <<
-		  " nexthop:"  << Items[i]->IsNextHop() <<
-		  " hasframes:" << Items[i]->IsHasFrames());
-
-    if(!Items[i]->IsNextHop() && Items[i]->IsHasFrames())
-      {
-	ItemPriorities[FIRST].push_back(i);
-      }
-    else if(Items[i]->IsNextHop() && Items[i]->IsHasFrames())
-      {
-	ItemPriorities[SECOND].push_back(i);
-      }
-    else if(Items[i]->IsNextHop() && !Items[i]->IsHasFrames())
-      {
-	ItemPriorities[THIRD].push_back(i);
-      }
-    else
-      {
-	ItemPriorities[FOURTH].push_back(i);
-      }
-  }
-
   for(int i = 0; i < 4; i++)
     {
-      if(ItemPriorities[i].size() > 0)
+      const std::vector<uint32_t> &bucket = m_buckets[i];
+      if(bucket.size() > 0)
 	{
-	  double randomValue = GetRandom(0, ItemPriorities[i].size());
-	  uint32_t num = ItemPriorities[i][randomValue];
-	  NS_LOG_DEBUG ("address:" << Items[num]->GetAddress());
-	  return Items[num]->GetAddress();
+	  uint32_t num;
+	  if (m_weighted)
+	    {
+	      num = SelectWeighted (bucket);
+	    }
+	  else
+	    {
+	      num = bucket[GetRandom(0, bucket.size())];
+	    }
+	  NS_LOG_DEBUG ("priority:" << i << " address:" << m_items[num].GetAddress());
+	  return m_items[num].GetAddress();
 	}
     }
   
@@ -94,58 +92,93 @@ SurroundingNodeTable::SelectSecondaryTransmissionNode()
   return addr.GetBroadcast();
 }
 uint32_t
-SurroundingNodeTable::GetRandom(double min, double max)
+SurroundingNodeTable::GetRandom(uint32_t min, uint32_t max)
 {
   if(min >= max)
     {
       NS_LOG_INFO(this << "min >= max");
-      return 0;
+      return min;
     }
-  
-  m_random->SetAttribute ("Min", DoubleValue (0));
-  m_random->SetAttribute ("Max", DoubleValue ());
-  double randomValue = m_random->GetValue ();
+  uint32_t randomValue = m_random->GetInteger (min, max - 1);
   NS_LOG_INFO("randomValue" << randomValue);
-  return (uint32_t)randomValue;
+  return randomValue;
+}
+
+int64_t
+SurroundingNodeTable::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_random->SetStream (stream);
+  return 1;
+}
+
+uint32_t
+SurroundingNodeTable::SelectWeighted (const std::vector<uint32_t> &bucket)
+{
+  double total = 0;
+  for (std::vector<uint32_t>::const_iterator i = bucket.begin (); i != bucket.end (); i++)
+    {
+      total += m_items[*i].GetLinkQuality ();
+    }
+  if (total <= 0)
+    {
+      return bucket[GetRandom (0, bucket.size ())];
+    }
+  double point = m_random->GetValue (0, total);
+  for (std::vector<uint32_t>::const_iterator i = bucket.begin (); i != bucket.end (); i++)
+    {
+      point -= m_items[*i].GetLinkQuality ();
+      if (point < 0)
+        {
+          return *i;
+        }
+    }
+  // rounding left the point at the very end of the range
+  return bucket.back ();
 }
   
 void
 SurroundingNodeTable::AddItem(Mac48Address address, bool nextHop, bool hasFrames)
 {
   NS_LOG_FUNCTION(this << address << nextHop << hasFrames);
-  Items.push_back(new SurroundingNodeItem(address, nextHop, hasFrames));
+  if (2 * (m_items.size () + 1) > m_slots.size ())
+    {
+      // keep the load factor at most 1/2
+      Rehash (m_slots.size () * 2);
+    }
+  uint32_t index = m_items.size ();
+  m_slots[Probe (address)] = index;
+  m_items.push_back (SurroundingNodeItem (address, nextHop, hasFrames));
+  m_bucketPositions.push_back (0);
+  Link (index);
 }
   
 void
 SurroundingNodeTable::InitItem()
 {
-  Items.clear();
+  m_items.clear ();
+  m_bucketPositions.clear ();
+  for (int i = 0; i < 4; i++)
+    {
+      m_buckets[i].clear ();
+    }
+  m_slots.assign (16, NO_ITEM);
 }
 bool
 SurroundingNodeTable::IsExistsAddress(Mac48Address address)
 {
   NS_LOG_FUNCTION(this);
-  for(unsigned int i = 0; i < Items.size(); i++)
-    {
-      NS_LOG_DEBUG(this << Items[i]->GetAddress());
-      if(Items[i]->GetAddress() == address)
-	{
-	  return true;
-	}
-    }
-  return false;
+  return Find (address) != NO_ITEM;
 }
   
 void
 SurroundingNodeTable::UpdateNextHop(Mac48Address address, bool nextHop)
 {
   NS_LOG_FUNCTION(this);
-  for(uint32_t i = 0; i < Items.size(); i++)
+  uint32_t index = Find (address);
+  if (index != NO_ITEM)
     {
-      if(Items[i]->GetAddress() == address)
-	{
-	  Items[i]->SetNextHop(nextHop);
-	}
+      SetFlags (index, nextHop, m_items[index].IsHasFrames ());
     }
 }
   
@@ -153,12 +186,10 @@ void
 SurroundingNodeTable::UpdateHasFrames(Mac48Address address, bool hasFrames)
 {
   NS_LOG_FUNCTION(this);
-  for(unsigned int i = 0; i < Items.size(); i++)
+  uint32_t index = Find (address);
+  if (index != NO_ITEM)
     {
-      if(Items[i]->GetAddress() == address)
-	{
-	  Items[i]->SetHasFrames(hasFrames);
-	}
+      SetFlags (index, m_items[index].IsNextHop (), hasFrames);
     }
 }
 
@@ -167,10 +198,10 @@ SurroundingNodeTable::UpdateTable(Mac48Address address, bool nextHop, bool hasFr
 {
 
   NS_LOG_FUNCTION(this << address << nextHop << hasFrames);
-  if(IsExistsAddress(address))
+  uint32_t index = Find (address);
+  if (index != NO_ITEM)
     {
-      UpdateNextHop(address, nextHop);
-      UpdateHasFrames(address, hasFrames);
+      SetFlags (index, nextHop, hasFrames);
     }
   else
     {
@@ -178,29 +209,133 @@ SurroundingNodeTable::UpdateTable(Mac48Address address, bool nextHop, bool hasFr
     }
 }
 
+void
+SurroundingNodeTable::UpdateLinkQuality(Mac48Address address, double snr)
+{
+  NS_LOG_FUNCTION(this << address << snr);
+  uint32_t index = Find (address);
+  if (index != NO_ITEM)
+    {
+      m_items[index].SetLinkQuality (snr);
+    }
+}
+
 void
 SurroundingNodeTable::DeleteItemByAddress(Mac48Address address)
 {
 
   NS_LOG_FUNCTION(this << address);
+  uint32_t index = Find (address);
+  if (index == NO_ITEM)
+    {
+      return;
+    }
+  Unlink (index);
+  // move the last item into the hole
+  uint32_t last = m_items.size () - 1;
+  if (index != last)
+    {
+      const SurroundingNodeItem &item = m_items[last];
+      enum PRIORITIES priority = GetPriority (item.IsNextHop (), item.IsHasFrames ());
+      m_buckets[priority][m_bucketPositions[last]] = index;
+      m_bucketPositions[index] = m_bucketPositions[last];
+      m_items[index] = item;
+    }
+  m_items.pop_back ();
+  m_bucketPositions.pop_back ();
+  // removing a key breaks the probe chains, rebuild them
+  Rehash (m_slots.size ());
+}
+
+enum SurroundingNodeTable::PRIORITIES
+SurroundingNodeTable::GetPriority (bool nextHop, bool hasFrames)
+{
+  if(!nextHop && hasFrames)
+    {
+      return FIRST;
+    }
+  else if(nextHop && hasFrames)
+    {
+      return SECOND;
+    }
+  else if(nextHop && !hasFrames)
+    {
+      return THIRD;
+    }
+  return FOURTH;
+}
+
+uint32_t
+SurroundingNodeTable::Find (Mac48Address address) const
+{
+  return m_slots[Probe (address)];
+}
 
-  for(unsigned int i = 0; i < Items.size(); i++)
+uint32_t
+SurroundingNodeTable::Probe (Mac48Address address) const
+{
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t i = Mac48AddressHash (address) & mask;
+  while (m_slots[i] != NO_ITEM && m_items[m_slots[i]].GetAddress () != address)
     {
-      NS_LOG_DEBUG(this << Items[i]->GetAddress());
-      if(Items[i]->GetAddress() == address)
-	{
-	  // delete
-	  Items.erase(Items.begin() + i);
-	  break;
-	}
+      i = (i + 1) & mask;
+    }
+  return i;
+}
+
+void
+SurroundingNodeTable::Rehash (uint32_t capacity)
+{
+  m_slots.assign (capacity, NO_ITEM);
+  for (uint32_t i = 0; i < m_items.size (); i++)
+    {
+      m_slots[Probe (m_items[i].GetAddress ())] = i;
     }
 }
+
+void
+SurroundingNodeTable::SetFlags (uint32_t index, bool nextHop, bool hasFrames)
+{
+  SurroundingNodeItem &item = m_items[index];
+  if (GetPriority (nextHop, hasFrames) == GetPriority (item.IsNextHop (), item.IsHasFrames ()))
+    {
+      item.SetNextHop (nextHop);
+      item.SetHasFrames (hasFrames);
+      return;
+    }
+  Unlink (index);
+  item.SetNextHop (nextHop);
+  item.SetHasFrames (hasFrames);
+  Link (index);
+}
+
+void
+SurroundingNodeTable::Link (uint32_t index)
+{
+  const SurroundingNodeItem &item = m_items[index];
+  std::vector<uint32_t> &bucket = m_buckets[GetPriority (item.IsNextHop (), item.IsHasFrames ())];
+  m_bucketPositions[index] = bucket.size ();
+  bucket.push_back (index);
+}
+
+void
+SurroundingNodeTable::Unlink (uint32_t index)
+{
+  const SurroundingNodeItem &item = m_items[index];
+  std::vector<uint32_t> &bucket = m_buckets[GetPriority (item.IsNextHop (), item.IsHasFrames ())];
+  uint32_t position = m_bucketPositions[index];
+  uint32_t moved = bucket.back ();
+  bucket[position] = moved;
+  m_bucketPositions[moved] = position;
+  bucket.pop_back ();
+}
   
 SurroundingNodeItem::SurroundingNodeItem (Mac48Address address, bool nextHop, bool hasFrames)
 {
   m_address = address;
   m_nextHop = nextHop;
   m_hasFrames = hasFrames;
+  m_linkQuality = 0;
 }
 
 SurroundingNodeItem::~SurroundingNodeItem ()
@@ -208,19 +343,19 @@ SurroundingNodeItem::~SurroundingNodeItem ()
 }
 
 Mac48Address
-SurroundingNodeItem::GetAddress()
+SurroundingNodeItem::GetAddress() const
 {
   return m_address;
 }
 
 bool
-SurroundingNodeItem::IsNextHop()
+SurroundingNodeItem::IsNextHop() const
 {
   return m_nextHop;
 }
 
 bool
-SurroundingNodeItem::IsHasFrames()
+SurroundingNodeItem::IsHasFrames() const
 {
   return m_hasFrames;
 }
@@ -237,10 +372,24 @@ SurroundingNodeItem::SetHasFrames(bool hasFrames)
   m_hasFrames = hasFrames;
 }
 
+double
+SurroundingNodeItem::GetLinkQuality() const
+{
+  return m_linkQuality;
+}
+
+void
+SurroundingNodeItem::SetLinkQuality(double snr)
+{
+  m_linkQuality = snr;
+}
+
 SurroundingNodeItem*
 SurroundingNodeItem::Copy ()
 {
-  return new SurroundingNodeItem(GetAddress(), IsNextHop(), IsHasFrames());
+  SurroundingNodeItem *item = new SurroundingNodeItem(GetAddress(), IsNextHop(), IsHasFrames());
+  item->SetLinkQuality (GetLinkQuality ());
+  return item;
 }
   
 } // namespace ns3
@@ -34,19 +34,33 @@ class SurroundingNodeItem
 public:
   ~SurroundingNodeItem();
   SurroundingNodeItem (Mac48Address address, bool nextHop, bool hasFrames);
-  Mac48Address GetAddress (void);
-  bool IsNextHop  (void);
-  bool IsHasFrames (void);
+  Mac48Address GetAddress (void) const;
+  bool IsNextHop  (void) const;
+  bool IsHasFrames (void) const;
   void SetNextHop  (bool nextHop);
   void SetHasFrames (bool hasFrames);
+  /**
+   * \return the linear SNR of the last frame received from the node
+   */
+  double GetLinkQuality (void) const;
+  void SetLinkQuality (double snr);
   SurroundingNodeItem* Copy ();
   
 private:
   Mac48Address m_address;
   bool m_nextHop;
   bool m_hasFrames;
+  double m_linkQuality;
 };
 
+/**
+ * Neighbours which may be chosen as the secondary transmission node.
+ *
+ * The items are kept by value in a dense vector indexed by an
+ * open-addressing hash of their address. Each item is also linked in
+ * the bucket of its priority class, which is updated whenever its
+ * flags change, so that the selection never scans the table.
+ */
 class SurroundingNodeTable : public Object
 {
 public:
@@ -59,7 +73,27 @@ public:
   void UpdateNextHop(Mac48Address address, bool nextHop);
   void UpdateHasFrames(Mac48Address address, bool hasFrames);
   void UpdateTable(Mac48Address address, bool nextHop, bool hasFrames);
-  uint32_t GetRandom(double min, double max);
+  /**
+   * Record the quality of the link from a node, used to weight the
+   * selection when WeightedSelection is enabled.
+   *
+   * \param address the node
+   * \param snr the linear SNR of the last frame received from it
+   */
+  void UpdateLinkQuality(Mac48Address address, double snr);
+  /**
+   * \return an integer drawn uniformly in [min, max), or min if the range is empty
+   */
+  uint32_t GetRandom(uint32_t min, uint32_t max);
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
 
   SurroundingNodeTable();
   ~SurroundingNodeTable();
@@ -70,8 +104,39 @@ private:
     THIRD  = 2,
     FOURTH = 3
   };
-  std::vector<SurroundingNodeItem*> Items;
+  /**
+   * \return the priority class of the given flags
+   */
+  static enum PRIORITIES GetPriority (bool nextHop, bool hasFrames);
+  /**
+   * \return the index of the item of the address, or NO_ITEM
+   */
+  uint32_t Find (Mac48Address address) const;
+  /**
+   * \return the slot holding the address, or the empty slot where it belongs
+   */
+  uint32_t Probe (Mac48Address address) const;
+  void Rehash (uint32_t capacity);
+  /**
+   * Change the flags of an item, moving it to its new priority bucket.
+   */
+  void SetFlags (uint32_t index, bool nextHop, bool hasFrames);
+  void Link (uint32_t index);
+  void Unlink (uint32_t index);
+  /**
+   * \return an item of the bucket, drawn with probability proportional
+   *         to its link quality
+   */
+  uint32_t SelectWeighted (const std::vector<uint32_t> &bucket);
+
+  static const uint32_t NO_ITEM = 0xffffffff;
+
+  std::vector<SurroundingNodeItem> m_items;
+  std::vector<uint32_t> m_bucketPositions; //!< position of each item in its bucket
+  std::vector<uint32_t> m_buckets[4];      //!< item indices of each priority class
+  std::vector<uint32_t> m_slots;           //!< item indices, power of two sized
   Ptr<UniformRandomVariable> m_random;  //!< Provides uniform random variables.
+  bool m_weighted;                      //!< Whether the selection is weighted by link quality
 };
 
 } // namespace ns3
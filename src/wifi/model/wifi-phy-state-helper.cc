@@ -60,9 +60,13 @@ WifiPhyStateHelper::WifiPhyStateHelper ()
     m_startRx (Seconds (0)),
     m_startCcaBusy (Seconds (0)),
     m_startSwitching (Seconds (0)),
-    m_previousStateChangeTime (Seconds (0))
+    m_previousStateChangeTime (Seconds (0)),
+    m_busytonePaddingTime (Seconds (0)),
+    m_txPaddingStart (Seconds (0)),
+    m_lastAccounting (Seconds (0))
 {
   NS_LOG_FUNCTION (this);
+  ResetStateTimes ();
 }
 
 void
@@ -79,6 +83,7 @@ void
 WifiPhyStateHelper::RegisterListener (WifiPhyListener *listener)
 {
   m_listeners.push_back (listener);
+  listener->NotifyRegistered (this);
 }
 
 bool
@@ -186,11 +191,17 @@ WifiPhyStateHelper::GetLastTxEndTime (void) const
 enum WifiPhy::State
 WifiPhyStateHelper::GetState (void)
 {
-  if (m_endTx > Simulator::Now() && m_rxing)
+  return GetStateAt (Simulator::Now ());
+}
+
+enum WifiPhy::State
+WifiPhyStateHelper::GetStateAt (Time time) const
+{
+  if (m_endTx > time && m_rxing)
     {
       return WifiPhy::FD;
     }
-  else if (m_endTx > Simulator::Now ())
+  else if (m_endTx > time)
     {
       return WifiPhy::TX;
     }
@@ -198,11 +209,11 @@ WifiPhyStateHelper::GetState (void)
     {
       return WifiPhy::RX;
     }
-  else if (m_endSwitching > Simulator::Now ())
+  else if (m_endSwitching > time)
     {
       return WifiPhy::SWITCHING;
     }
-  else if (m_endCcaBusy > Simulator::Now ())
+  else if (m_endCcaBusy > time)
     {
       return WifiPhy::CCA_BUSY;
     }
@@ -212,6 +223,88 @@ WifiPhyStateHelper::GetState (void)
     }
 }
 
+void
+WifiPhyStateHelper::AccountStateTimes (void)
+{
+  Time now = Simulator::Now ();
+  Time t = m_lastAccounting;
+  // between two calls the state only changes when one of the end
+  // times is reached
+  while (t < now)
+    {
+      Time next = GetNextEnd (t, now);
+      m_stateTimes[GetStateAt (t)] += next - t;
+      if (m_txPaddingStart < next && m_endTx > t)
+        {
+          m_busytonePaddingTime += Min (next, m_endTx) - Max (t, m_txPaddingStart);
+        }
+      t = next;
+    }
+  m_lastAccounting = now;
+}
+
+Time
+WifiPhyStateHelper::GetNextEnd (Time t, Time limit) const
+{
+  Time next = limit;
+  if (m_endTx > t && m_endTx < next)
+    {
+      next = m_endTx;
+    }
+  if (m_endSwitching > t && m_endSwitching < next)
+    {
+      next = m_endSwitching;
+    }
+  if (m_endCcaBusy > t && m_endCcaBusy < next)
+    {
+      next = m_endCcaBusy;
+    }
+  return next;
+}
+
+Time
+WifiPhyStateHelper::GetNextStateChangeTime (void) const
+{
+  return GetNextEnd (Simulator::Now (), Time::Max ());
+}
+
+Time
+WifiPhyStateHelper::GetStateTime (enum WifiPhy::State state)
+{
+  NS_ASSERT (state <= WifiPhy::SWITCHING);
+  AccountStateTimes ();
+  return m_stateTimes[state];
+}
+
+Time
+WifiPhyStateHelper::GetBusytonePaddingTime (void)
+{
+  AccountStateTimes ();
+  return m_busytonePaddingTime;
+}
+
+void
+WifiPhyStateHelper::ResetStateTimes (void)
+{
+  for (uint32_t i = 0; i <= WifiPhy::SWITCHING; i++)
+    {
+      m_stateTimes[i] = Seconds (0);
+    }
+  m_busytonePaddingTime = Seconds (0);
+  m_lastAccounting = Simulator::Now ();
+}
+
+void
+WifiPhyStateHelper::NotifyTxPadding (Time paddingStart)
+{
+  NS_ASSERT (paddingStart >= Simulator::Now ());
+  m_txPaddingStart = paddingStart;
+  for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
+    {
+      (*i)->NotifyTxPadding (paddingStart);
+    }
+}
+
 void
 WifiPhyStateHelper::NotifyTxStart (Time duration)
 {
@@ -302,6 +395,7 @@ WifiPhyStateHelper::SwitchToTx (Time txDuration, Ptr<const Packet> packet, WifiM
                                 WifiPreamble preamble, uint8_t txPower)
 {
   NS_ASSERT (!IsStateFd());
+  AccountStateTimes ();
   m_txTrace (packet, txMode, preamble, txPower);
   NotifyTxStart (txDuration);
   Time now = Simulator::Now ();
@@ -331,6 +425,7 @@ WifiPhyStateHelper::SwitchToTx (Time txDuration, Ptr<const Packet> packet, WifiM
     }
   m_previousStateChangeTime = now;
   m_endTx = now + txDuration;
+  m_txPaddingStart = m_endTx;
   m_startTx = now;
   NS_LOG_DEBUG("tx: start=" << m_startTx << " end=" << m_endTx);
 }
@@ -338,6 +433,9 @@ void
 WifiPhyStateHelper::PostponeTx(Time txEndTime)
 {
   NS_LOG_FUNCTION(this <<" txEndTime=" << txEndTime);
+  AccountStateTimes ();
+  // the extension is sent as busytone padding
+  m_txPaddingStart = Min (m_txPaddingStart, m_endTx);
   m_endTx = txEndTime;
   NotifyTxPostpone (txEndTime);
 }
@@ -346,6 +444,7 @@ void
 WifiPhyStateHelper::PostponeRx(Time rxEndTime)
 {
   NS_LOG_FUNCTION(this << " rxEndTime=" << rxEndTime);
+  AccountStateTimes ();
   m_endRx = rxEndTime;
   NotifyRxPostpone (rxEndTime);
 }
@@ -356,6 +455,7 @@ WifiPhyStateHelper::SwitchToRx (Time rxDuration)
   NS_ASSERT (IsStateIdle () || IsStateCcaBusy () || IsStateTx () ||
              IsStateRx () || IsStateFd ());
   // NS_ASSERT (!m_rxing);
+  AccountStateTimes ();
   NotifyRxStart (rxDuration);
   Time now = Simulator::Now ();
   switch (GetState ())
@@ -391,6 +491,7 @@ WifiPhyStateHelper::SwitchToRx (Time rxDuration)
 void
 WifiPhyStateHelper::SwitchToChannelSwitching (Time switchingDuration)
 {
+  AccountStateTimes ();
   NotifySwitchingStart (switchingDuration);
   Time now = Simulator::Now ();
   switch (GetState ())
@@ -463,6 +564,7 @@ WifiPhyStateHelper::DoSwitchFromRx (void)
 {
   NS_ASSERT (IsStateRx () || IsStateFd ());
   NS_ASSERT (m_rxing);
+  AccountStateTimes ();
 
   Time now = Simulator::Now ();
   m_stateLogger (m_startRx, now - m_startRx, WifiPhy::RX);
@@ -474,6 +576,7 @@ WifiPhyStateHelper::DoSwitchFromRx (void)
 void
 WifiPhyStateHelper::SwitchMaybeToCcaBusy (Time duration)
 {
+  AccountStateTimes ();
   NotifyMaybeCcaBusyStart (duration);
   Time now = Simulator::Now ();
   switch (GetState ())
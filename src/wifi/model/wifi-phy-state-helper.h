@@ -44,6 +44,45 @@ public:
   Time GetLastRxEndTime() const;
   Time GetLastTxEndTime() const;
 
+  /**
+   * Return the time spent in a state since the last reset. The time is
+   * accounted incrementally, so this is exact at any point of the
+   * simulation, including the extensions made by PostponeTx and
+   * PostponeRx. The time in FD is the time transmission and reception
+   * overlapped.
+   *
+   * \param state the state
+   * \return the time spent in the state
+   */
+  Time GetStateTime (enum WifiPhy::State state);
+  /**
+   * Return the time spent transmitting busytone padding since the last
+   * reset: busytone frames, the padding sent after a data frame and
+   * the extensions of a transmission by PostponeTx.
+   *
+   * \return the time spent transmitting busytone padding
+   */
+  Time GetBusytonePaddingTime (void);
+  /**
+   * Restart the accounting of GetStateTime and GetBusytonePaddingTime.
+   */
+  void ResetStateTimes (void);
+  /**
+   * Mark the end of the current transmission, from paddingStart, as
+   * busytone padding. Must be called after SwitchToTx.
+   *
+   * \param paddingStart the time the padding starts
+   */
+  void NotifyTxPadding (Time paddingStart);
+  /**
+   * Return the next time the state changes without a call to this
+   * helper: the end of the transmission, of the channel switching or
+   * of the CCA busy period. The end of a reception is always notified.
+   *
+   * \return the next state change, or Time::Max () if none is pending
+   */
+  Time GetNextStateChangeTime (void) const;
+
   WifiPhyStateHelper ();
 
   /**
@@ -224,6 +263,22 @@ private:
   void DoSwitchFromRx (void);
   void NotifyTxPostpone (Time endTime);
   void NotifyRxPostpone (Time endTime);
+  /**
+   * \param time a time not before the last change of the end times
+   * \return the state at this time
+   */
+  enum WifiPhy::State GetStateAt (Time time) const;
+  /**
+   * \param t a time
+   * \param limit a time after t
+   * \return the first end of a period in (t, limit), or limit
+   */
+  Time GetNextEnd (Time t, Time limit) const;
+  /**
+   * Add the time elapsed since the last call to the state times. Called
+   * before anything which the state depends on is changed.
+   */
+  void AccountStateTimes (void);
 
   bool m_rxing;
   Time m_endTx;
@@ -235,6 +290,10 @@ private:
   Time m_startCcaBusy;
   Time m_startSwitching;
   Time m_previousStateChangeTime;
+  Time m_stateTimes[WifiPhy::SWITCHING + 1];
+  Time m_busytonePaddingTime;
+  Time m_txPaddingStart;
+  Time m_lastAccounting;
 
   Listeners m_listeners;
   TracedCallback<Ptr<const Packet>, double, WifiMode, enum WifiPreamble> m_rxOkTrace;
@@ -19,6 +19,7 @@
  */
 
 #include "wifi-phy.h"
+#include "wifi-phy-state-helper.h"
 #include "mac-low.h"
 #include "wifi-mode.h"
 #include "wifi-channel.h"
@@ -45,6 +46,16 @@ WifiPhyListener::~WifiPhyListener ()
 {
 }
 
+void
+WifiPhyListener::NotifyTxPadding (Time paddingStart)
+{
+}
+
+void
+WifiPhyListener::NotifyRegistered (Ptr<WifiPhyStateHelper> state)
+{
+}
+
 /****************************************************************
  *       The actual WifiPhy class
  ****************************************************************/
@@ -245,6 +256,12 @@ WifiPhy::SetReceivingAddress4 (Mac48Address addr4)
   m_receivingAddress4 = addr4;
 }
   
+void
+WifiPhy::SetReceivingMetadata (const FdTxMetadata &metadata)
+{
+  m_receivingMetadata = metadata;
+}
+
 WifiTxVector
 WifiPhy::GetReceivingTxVector ()
 {
@@ -263,6 +280,12 @@ WifiPhy::GetReceivingAddress4 ()
   return m_receivingAddress4;
 }
 
+FdTxMetadata
+WifiPhy::GetReceivingMetadata ()
+{
+  return m_receivingMetadata;
+}
+
 uint32_t
 WifiPhy::GetPlcpHeaderDurationMicroSeconds (WifiMode payloadMode, WifiPreamble preamble)
 {
@@ -374,54 +397,22 @@ WifiPhy::GetPlcpPreambleDurationMicroSeconds (WifiMode payloadMode, WifiPreamble
     }
 }
 
-uint32_t
-WifiPhy::GetPacketSizeFromDuration (Time time, WifiTxVector txvector)
+const WifiPhy::PayloadSymbol &
+WifiPhy::GetPayloadSymbol (WifiTxVector txvector)
 {
-  WifiMode payloadMode=txvector.GetMode();
-  uint32_t symbolDurationUs;
-  
-  switch (payloadMode.GetModulationClass ())
+  static PayloadSymbolTable table;
+  WifiMode payloadMode = txvector.GetMode ();
+  uint64_t key = ((uint64_t)payloadMode.GetUid () << 16) | (txvector.GetNss () << 1) | (txvector.IsStbc () ? 1 : 0);
+  PayloadSymbolTable::const_iterator it = table.find (key);
+  if (it != table.end ())
     {
-    case WIFI_MOD_CLASS_OFDM:
-    case WIFI_MOD_CLASS_ERP_OFDM:
-      {
-        // IEEE Std 802.11-2007, section 17.3.2.3, table 17-4
-        // corresponds to T_{SYM} in the table
-
-        switch (payloadMode.GetBandwidth ())
-          {
-          case 20000000:
-          default:
-            symbolDurationUs = 4;
-            break;
-          case 10000000:
-            symbolDurationUs = 8;
-            break;
-          case 5000000:
-            symbolDurationUs = 16;
-            break;
-          }
-      }
-      break;
-    default:
-      NS_FATAL_ERROR ("unsupported modulation class");
-      return 0;
+      return it->second;
     }
-  double numDataBitsPerSymbol = payloadMode.GetDataRate () * symbolDurationUs / 1e6;
-  // ؂グ
-  uint32_t numSymbols = (time.GetDouble() / 1000)/ symbolDurationUs;
-  double Nes=1;
-  uint32_t numBytes = (((numSymbols * numDataBitsPerSymbol) - 16 - (6 * Nes)) / 8);
-  return numBytes;
-}
 
-double
-WifiPhy::GetPayloadDurationMicroSeconds (uint32_t size, WifiTxVector txvector)
-{
-  WifiMode payloadMode=txvector.GetMode();
-
-  NS_LOG_FUNCTION (size << payloadMode);
- 
+  PayloadSymbol symbol;
+  symbol.serviceBits = 16 + 6;
+  symbol.stbc = 1;
+  symbol.extensionUs = 0;
   switch (payloadMode.GetModulationClass ())
     {
     case WIFI_MOD_CLASS_OFDM:
@@ -429,100 +420,113 @@ WifiPhy::GetPayloadDurationMicroSeconds (uint32_t size, WifiTxVector txvector)
       {
         // IEEE Std 802.11-2007, section 17.3.2.3, table 17-4
         // corresponds to T_{SYM} in the table
-        uint32_t symbolDurationUs;
-
         switch (payloadMode.GetBandwidth ())
           {
           case 20000000:
           default:
-            symbolDurationUs = 4;
+            symbol.durationUs = 4;
             break;
           case 10000000:
-            symbolDurationUs = 8;
+            symbol.durationUs = 8;
             break;
           case 5000000:
-            symbolDurationUs = 16;
+            symbol.durationUs = 16;
             break;
           }
-
         // IEEE Std 802.11-2007, section 17.3.2.2, table 17-3
         // corresponds to N_{DBPS} in the table
-        double numDataBitsPerSymbol = payloadMode.GetDataRate () * symbolDurationUs / 1e6;
-
-        // IEEE Std 802.11-2007, section 17.3.5.3, equation (17-11)
-        uint32_t numSymbols = lrint (ceil ((16 + size * 8.0 + 6.0) / numDataBitsPerSymbol));
-
-        NS_LOG_DEBUG("DurationUs=" << symbolDurationUs << " Rate=" << payloadMode.GetDataRate () <<
-                     " BitPerSymbol=" << numDataBitsPerSymbol << " numSymbols=" << numSymbols);
-
+        symbol.bitsPerSymbol = payloadMode.GetDataRate () * symbol.durationUs / 1e6;
         // Add signal extension for ERP PHY
         if (payloadMode.GetModulationClass () == WIFI_MOD_CLASS_ERP_OFDM)
           {
-            return numSymbols * symbolDurationUs + 6;
-          }
-        else
-          {
-            return numSymbols * symbolDurationUs;
+            symbol.extensionUs = 6;
           }
+        break;
       }
     case WIFI_MOD_CLASS_HT:
       {
-         double symbolDurationUs;
-         double m_Stbc;
         //if short GI data rate is used then symbol duration is 3.6us else symbol duration is 4us
         //In the future has to create a stationmanager that only uses these data rates if sender and reciever support GI
-         if (payloadMode.GetUniqueName() == "OfdmRate135MbpsBW40MHzShGi" || payloadMode.GetUniqueName() == "OfdmRate65MbpsBW20MHzShGi" )
-           {
-             symbolDurationUs=3.6;
-           }
-         else
-           {
-             switch (payloadMode.GetDataRate ()/ (txvector.GetNss()))
-               { //shortGi
-                  case 7200000:
-                  case 14400000:
-                  case 21700000:
-                  case 28900000:
-                  case 43300000:
-                  case 57800000:
-                  case 72200000:
-                  case 15000000:
-                  case 30000000:
-                  case 45000000:
-                  case 60000000:
-                  case 90000000:
-                  case 120000000:
-                  case 150000000:
-                    symbolDurationUs=3.6;
-                    break;               
-                 default:
-                    symbolDurationUs=4;
+        if (payloadMode.GetUniqueName () == "OfdmRate135MbpsBW40MHzShGi" || payloadMode.GetUniqueName () == "OfdmRate65MbpsBW20MHzShGi" )
+          {
+            symbol.durationUs = 3.6;
+          }
+        else
+          {
+            switch (payloadMode.GetDataRate () / (txvector.GetNss ()))
+              { //shortGi
+              case 7200000:
+              case 14400000:
+              case 21700000:
+              case 28900000:
+              case 43300000:
+              case 57800000:
+              case 72200000:
+              case 15000000:
+              case 30000000:
+              case 45000000:
+              case 60000000:
+              case 90000000:
+              case 120000000:
+              case 150000000:
+                symbol.durationUs = 3.6;
+                break;
+              default:
+                symbol.durationUs = 4;
               }
-           }
-         if  (txvector.IsStbc())
-            m_Stbc=2;
-         else
-           m_Stbc=1;
-         double numDataBitsPerSymbol = payloadMode.GetDataRate () *txvector.GetNss()  * symbolDurationUs / 1e6;
-         //check tables 20-35 and 20-36 in the standard to get cases when nes =2
-         double Nes=1;
-        // IEEE Std 802.11n, section 20.3.11, equation (20-32)
-        uint32_t numSymbols = lrint (m_Stbc*ceil ((16 + size * 8.0 + 6.0*Nes) / (m_Stbc* numDataBitsPerSymbol)));
-       
-        return numSymbols * symbolDurationUs;
-         
+          }
+        if (txvector.IsStbc ())
+          {
+            symbol.stbc = 2;
+          }
+        symbol.bitsPerSymbol = payloadMode.GetDataRate () * txvector.GetNss () * symbol.durationUs / 1e6;
+        //check tables 20-35 and 20-36 in the standard to get cases when nes =2
+        break;
       }
     case WIFI_MOD_CLASS_DSSS:
       // IEEE Std 802.11-2007, section 18.2.3.5
-      NS_LOG_LOGIC (" size=" << size
-                             << " mode=" << payloadMode
-                             << " rate=" << payloadMode.GetDataRate () );
-      return lrint (ceil ((size * 8.0) / (payloadMode.GetDataRate () / 1.0e6)));
-
+      // the payload is counted in microseconds, without service bits
+      symbol.durationUs = 1;
+      symbol.bitsPerSymbol = payloadMode.GetDataRate () / 1.0e6;
+      symbol.serviceBits = 0;
+      break;
     default:
       NS_FATAL_ERROR ("unsupported modulation class");
-      return 0;
     }
+  NS_LOG_DEBUG ("PayloadSymbol mode=" << payloadMode << " nss=" << (uint32_t)txvector.GetNss () <<
+                " DurationUs=" << symbol.durationUs << " BitPerSymbol=" << symbol.bitsPerSymbol <<
+                " stbc=" << symbol.stbc);
+  return table.insert (std::make_pair (key, symbol)).first->second;
+}
+
+double
+WifiPhy::GetPayloadDurationMicroSeconds (uint32_t size, WifiTxVector txvector)
+{
+  NS_LOG_FUNCTION (size << txvector.GetMode ());
+  const PayloadSymbol &symbol = GetPayloadSymbol (txvector);
+  // IEEE Std 802.11-2007, section 17.3.5.3, equation (17-11),
+  // IEEE Std 802.11n, section 20.3.11, equation (20-32)
+  // and IEEE Std 802.11-2007, section 18.2.3.5 for DSSS
+  uint32_t numSymbols = lrint (symbol.stbc * ceil ((symbol.serviceBits + size * 8.0) / (symbol.stbc * symbol.bitsPerSymbol)));
+  return numSymbols * symbol.durationUs + symbol.extensionUs;
+}
+
+Time
+WifiPhy::GetPayloadSymbolDuration (WifiTxVector txvector)
+{
+  const PayloadSymbol &symbol = GetPayloadSymbol (txvector);
+  return NanoSeconds (lrint (symbol.stbc * symbol.durationUs * 1000));
+}
+
+Time
+WifiPhy::GetBusytoneDuration (Time duration, WifiTxVector txvector)
+{
+  if (!duration.IsStrictlyPositive ())
+    {
+      return Seconds (0);
+    }
+  int64_t step = GetPayloadSymbolDuration (txvector).GetNanoSeconds ();
+  return NanoSeconds ((duration.GetNanoSeconds () / step) * step);
 }
 
 Time
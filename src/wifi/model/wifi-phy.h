@@ -22,6 +22,7 @@
 #define WIFI_PHY_H
 
 #include <stdint.h>
+#include <map>
 #include "ns3/callback.h"
 #include "ns3/packet.h"
 #include "ns3/object.h"
@@ -35,11 +36,13 @@
 #include "ns3/traced-callback.h"
 #include "ns3/wifi-antenna-model.h"
 #include "wifi-tx-vector.h"
+#include "fd-tx-metadata.h"
 
 namespace ns3 {
 
 class WifiChannel;
 class NetDevice;
+class WifiPhyStateHelper;
 
 /**
  * \brief receive notifications about phy events.
@@ -111,6 +114,22 @@ public:
   virtual void NotifySwitchingStart (Time duration) = 0;
   virtual void NotifyTxPostpone (Time endTime) = 0;
   virtual void NotifyRxPostpone (Time endTime) = 0;
+  /**
+   * \param paddingStart the time from which the current transmission
+   *        only carries busytone padding, up to its (possibly postponed)
+   *        end
+   *
+   * The default implementation does nothing.
+   */
+  virtual void NotifyTxPadding (Time paddingStart);
+  /**
+   * \param state the state helper this listener was registered on
+   *
+   * Called once by WifiPhyStateHelper::RegisterListener, so that the
+   * listener can read the state and the state times of the PHY.
+   * The default implementation does nothing.
+   */
+  virtual void NotifyRegistered (Ptr<WifiPhyStateHelper> state);
 };
 
 
@@ -174,9 +193,15 @@ public:
   void SetReceivingTxVector (WifiTxVector txVector);
   void SetReceivingPreamble (WifiPreamble preamble);
   void SetReceivingAddress4 (Mac48Address addr4);
+  void SetReceivingMetadata (const FdTxMetadata &metadata);
   WifiTxVector GetReceivingTxVector ();
   WifiPreamble GetReceivingPreamble ();
   Mac48Address GetReceivingAddress4 ();
+  /**
+   * \return the full-duplex metadata of the frame last handed to the
+   *         receive callback
+   */
+  FdTxMetadata GetReceivingMetadata ();
 
   WifiPhy ();
   virtual ~WifiPhy ();
@@ -217,6 +242,16 @@ public:
    *        transmission power is calculated as txPowerMin + txPowerLevel * (txPowerMax - txPowerMin) / nTxLevels
    */
   virtual void SendPacket (Ptr<const Packet> packet, WifiMode mode, enum WifiPreamble preamble, WifiTxVector txvector) = 0;
+  /**
+   * \param packet the packet to send
+   * \param mode the transmission mode to use to send this packet
+   * \param preamble the type of preamble to use to send this packet.
+   * \param txvector the txvector that has tx parameters
+   * \param metadata the full-duplex information delivered to the
+   *        receivers along with the packet
+   */
+  virtual void SendPacket (Ptr<const Packet> packet, WifiMode mode, enum WifiPreamble preamble, WifiTxVector txvector,
+                           const FdTxMetadata &metadata) = 0;
 
   /**
    * \param listener the new listener
@@ -335,7 +370,23 @@ public:
    */
   static double GetPayloadDurationMicroSeconds (uint32_t size, WifiTxVector txvector);
 
-  static uint32_t GetPacketSizeFromDuration (Time time, WifiTxVector txvector);
+  /**
+   * \param txvector the transmission parameters used for the payload
+   *
+   * \return the smallest step by which the payload of a frame sent with
+   *         txvector grows: one OFDM symbol (two with STBC), or one
+   *         microsecond for DSSS
+   */
+  static Time GetPayloadSymbolDuration (WifiTxVector txvector);
+
+  /**
+   * \param duration the time to fill with busytone padding
+   * \param txvector the transmission parameters used for the payload
+   *
+   * \return duration rounded down to a whole number of payload symbols,
+   *         so that a frame padded with it ends on a symbol boundary
+   */
+  static Time GetBusytoneDuration (Time duration, WifiTxVector txvector);
   /**
    * The WifiPhy::GetNModes() and WifiPhy::GetMode() methods are used
    * (e.g., by a WifiRemoteStationManager) to determine the set of
@@ -1090,6 +1141,28 @@ public:
   virtual void SetChannelBonding (bool channelbonding) = 0 ;
 
 private:
+  /**
+   * The payload symbol parameters of a WifiTxVector, which only depend
+   * on its mode, number of spatial streams and STBC.
+   */
+  struct PayloadSymbol
+  {
+    double durationUs;     //!< T_{SYM}, or one microsecond for DSSS
+    double bitsPerSymbol;  //!< N_{DBPS}
+    double serviceBits;    //!< SERVICE and tail bits added to the payload
+    uint32_t stbc;         //!< symbols are sent by pairs with STBC
+    double extensionUs;    //!< signal extension of the ERP PHY
+  };
+  typedef std::map<uint64_t, PayloadSymbol> PayloadSymbolTable;
+
+  /**
+   * \param txvector the transmission parameters used for the payload
+   *
+   * \return the payload symbol parameters of txvector, computed on the
+   *         first use and looked up in a table afterwards
+   */
+  static const PayloadSymbol & GetPayloadSymbol (WifiTxVector txvector);
+
   /**
    * The trace source fired when a packet begins the transmission process on
    * the medium.
@@ -1167,6 +1240,7 @@ private:
   WifiTxVector m_receivingTxVector;
   WifiPreamble m_receivingPreamble;
   Mac48Address m_receivingAddress4;
+  FdTxMetadata m_receivingMetadata;
 };
 
 /**
@@ -24,12 +24,16 @@
 #include "ns3/node.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
 #include "ns3/object-factory.h"
 #include "yans-wifi-channel.h"
 #include "yans-wifi-phy.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
-#include "ns3/wifi-switched-beam-antenna-model.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 NS_LOG_COMPONENT_DEFINE ("YansWifiChannel");
 
@@ -38,6 +42,39 @@ namespace ns3 {
 NS_OBJECT_ENSURE_REGISTERED (YansWifiChannel)
   ;
 
+/**
+ * Listener for antenna gain pattern changes. Forwards to YansWifiChannel
+ */
+class LinkBudgetAntennaListener : public WifiAntennaListener
+{
+public:
+  /**
+   * Create a LinkBudgetAntennaListener for the i-th PHY of the given channel.
+   *
+   * \param channel
+   * \param i
+   */
+  LinkBudgetAntennaListener (const YansWifiChannel *channel, uint32_t i)
+    : m_channel (channel),
+      m_index (i)
+  {
+  }
+  virtual ~LinkBudgetAntennaListener ()
+  {
+  }
+  virtual void NotifyChangeAntennaMode (int mode)
+  {
+    // the gain of each mode is cached separately
+  }
+  virtual void NotifyChangeGainPattern (void)
+  {
+    m_channel->NotifyChangeGainPattern (m_index);
+  }
+private:
+  const YansWifiChannel *m_channel; //!< YansWifiChannel to forward events to
+  uint32_t m_index;                 //!< index of the PHY in the PHY list
+};
+
 TypeId
 YansWifiChannel::GetTypeId (void)
 {
@@ -52,17 +89,92 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("SpatialIndex",
+                   "If true, keep a grid index of the PHY positions (cell size = MaxRange) "
+                   "so that each transmission only visits the PHYs of the neighbouring cells. "
+                   "The cells of the moving PHYs (non-zero velocity or a CourseChange since "
+                   "the last refresh) are refreshed from their positions once per time step. "
+                   "It has no effect when MaxRange is zero.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_spatialIndexEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxRange",
+                   "Receivers farther than this distance (m) from the sender are not scheduled. "
+                   "Zero disables the cutoff.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&YansWifiChannel::SetMaxRange,
+                                       &YansWifiChannel::GetMaxRange),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("MinRxPower",
+                   "Receivers whose rx power (dBm, before the receiver gain) is below this "
+                   "value are not scheduled. The default keeps every receiver.",
+                   DoubleValue (-std::numeric_limits<double>::infinity ()),
+                   MakeDoubleAccessor (&YansWifiChannel::m_minRxPowerDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("LinkBudgetCache",
+                   "If true, cache the path loss, the propagation delay and the sender antenna "
+                   "gain of each link and antenna mode until a node moves or the antenna reports "
+                   "a new gain pattern (orientation, beamwidth or gain set on the antenna). "
+                   "Changes made on the orientation model itself are not seen. Only valid with "
+                   "deterministic loss models whose loss does not depend on the tx power.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_linkBudgetCacheEnabled),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_spatialIndexEnabled (false),
+    m_maxRange (0.0),
+    m_minRxPowerDbm (-std::numeric_limits<double>::infinity ()),
+    m_spatialIndexValid (false),
+    m_linkBudgetCacheEnabled (false),
+    m_connectedPhys (0),
+    m_nSharedDeliveries (0)
 {
 }
 YansWifiChannel::~YansWifiChannel ()
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_phyList.clear ();
+  m_grid.clear ();
+  m_phyCell.clear ();
+  m_movingPhys.clear ();
+  m_phyIndex.clear ();
+  m_linkBudgets.clear ();
+  DisconnectPhys ();
+}
+
+void
+YansWifiChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  DisconnectPhys ();
+  WifiChannel::DoDispose ();
+}
+
+void
+YansWifiChannel::DisconnectPhys (void)
+{
+  // The mobility models and the antennas may outlive the channel: they
+  // must not call back into it. ConnectPhys bound a const pointer, the
+  // callbacks only compare equal with the same pointer type.
+  const YansWifiChannel *self = this;
+  for (uint32_t j = 0; j < m_connectedMobilities.size (); j++)
+    {
+      m_connectedMobilities[j]->TraceDisconnectWithoutContext ("CourseChange",
+                                                               MakeCallback (&YansWifiChannel::NotifyCourseChange, self));
+    }
+  m_connectedMobilities.clear ();
+  m_mobilityIndex.clear ();
+  for (uint32_t i = 0; i < m_antennaListeners.size (); i++)
+    {
+      m_listenedAntennas[i]->UnregisterListener (m_antennaListeners[i]);
+      delete m_antennaListeners[i];
+    }
+  m_antennaListeners.clear ();
+  m_listenedAntennas.clear ();
 }
 
 void
@@ -77,14 +189,20 @@ YansWifiChannel::SetPropagationDelayModel (Ptr<PropagationDelayModel> delay)
 }
 
 void
-YansWifiChannel::NotifyPostponeSend(Ptr<YansWifiPhy> sender, Ptr<Packet> packet, double txPowerDbm,
-                                    WifiTxVector txVector, WifiPreamble preamble, Time rxEndTime)
+YansWifiChannel::NotifyPostponeSend(Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, const FdTxMetadata &fdMetadata,
+                                    double txPowerDbm, WifiTxVector txVector, WifiPreamble preamble, Time rxEndTime)
 {
+  YansWifiPhy::RxMetadata metadata;
+  metadata.tx = fdMetadata;
   Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
   NS_ASSERT (senderMobility != 0);
-  uint32_t j = 0;
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  std::vector<uint32_t> candidates;
+  GetCandidates (sender, senderMobility, candidates);
+  uint32_t senderIndex = m_phyIndex.find (PeekPointer (sender))->second;
+  for (std::vector<uint32_t>::const_iterator k = candidates.begin (); k != candidates.end (); k++)
     {
+      uint32_t j = *k;
+      PhyList::const_iterator i = m_phyList.begin () + j;
       if (sender != (*i))
         {
           // For now don't account for inter channel interference
@@ -93,9 +211,28 @@ YansWifiChannel::NotifyPostponeSend(Ptr<YansWifiPhy> sender, Ptr<Packet> packet,
               continue;
             }
           Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          Ptr<Packet> copy = packet->Copy ();
+          // The MinRxPower cutoff is not applied here: the power computed
+          // below has no antenna gain, and a receiver which heard the start
+          // of the frame must also hear its extension.
+          if (IsOutOfRange (senderMobility, receiverMobility))
+            {
+              continue;
+            }
+          Time delay;
+          double rxPowerDbm;
+          if (m_linkBudgetCacheEnabled)
+            {
+              const LinkBudget &link = GetLinkBudget (senderIndex, j, senderMobility, receiverMobility);
+              delay = link.delay;
+              rxPowerDbm = txPowerDbm - link.lossDb;
+            }
+          else
+            {
+              delay = m_delay->GetDelay (senderMobility, receiverMobility);
+              rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+            }
+          metadata.rxPowerDbm = rxPowerDbm;
+          m_nSharedDeliveries++;
           Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
           uint32_t dstNode;
           if (dstNetDevice == 0)
@@ -108,20 +245,26 @@ YansWifiChannel::NotifyPostponeSend(Ptr<YansWifiPhy> sender, Ptr<Packet> packet,
             }
           Simulator::ScheduleWithContext (dstNode, Seconds(0),
                                           &YansWifiChannel::NotifyChangeEndReceive,
-                                          this, j, copy, rxPowerDbm, preamble,
+                                          this, j, packet, metadata, preamble,
                                           rxEndTime + delay);
         }
     }
 }
 void
-YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm,
-                       WifiTxVector txVector, WifiPreamble preamble) const
+YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, const FdTxMetadata &fdMetadata,
+                       double txPowerDbm, WifiTxVector txVector, WifiPreamble preamble) const
 {
   Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
   NS_ASSERT (senderMobility != 0);
-  uint32_t j = 0;
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  std::vector<uint32_t> candidates;
+  GetCandidates (sender, senderMobility, candidates);
+  uint32_t senderIndex = m_phyIndex.find (PeekPointer (sender))->second;
+  YansWifiPhy::RxMetadata metadata;
+  metadata.tx = fdMetadata;
+  for (std::vector<uint32_t>::const_iterator k = candidates.begin (); k != candidates.end (); k++)
     {
+      uint32_t j = *k;
+      PhyList::const_iterator i = m_phyList.begin () + j;
       if (sender != (*i))
         {
           // For now don't account for inter channel interference
@@ -131,23 +274,58 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
             }
 
           Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+          if (IsOutOfRange (senderMobility, receiverMobility))
+            {
+              continue;
+            }
           /*
+          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
           double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
           NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
                         "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
           */
 
           // [2014/09/07] add sugiyama
+          Time delay;
           double txGain = 0;
+          double rxPowerDbm;
           Ptr<WifiAntennaModel> sendAnt = sender->GetAntenna ();
-          if(sendAnt != 0){
-            int tmpAntennaMode = m_phyList[j]->GetAntenna ()->GetAntennaMode ();
-            m_phyList[j]->GetAntenna ()->SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
-            txGain = sendAnt->GetGainDb (senderMobility, receiverMobility);
-            m_phyList[j]->GetAntenna ()->SetAntennaMode (tmpAntennaMode);
-          }
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm + txGain, senderMobility, receiverMobility);
+          if (m_linkBudgetCacheEnabled)
+            {
+              LinkBudget &link = GetLinkBudget (senderIndex, j, senderMobility, receiverMobility);
+              delay = link.delay;
+              if (sendAnt != 0)
+                {
+                  int mode = sendAnt->GetAntennaMode ();
+                  NS_ASSERT (mode >= 0 && mode < sendAnt->GetNAntennaModes ());
+                  if (link.gainEpoch.size () <= (uint32_t)mode)
+                    {
+                      link.gainEpoch.resize (sendAnt->GetNAntennaModes (), 0);
+                      link.gainDb.resize (sendAnt->GetNAntennaModes ());
+                    }
+                  if (link.gainEpoch[mode] != m_gainEpoch[senderIndex])
+                    {
+                      link.gainDb[mode] = sendAnt->GetGainDb (senderMobility, receiverMobility, mode);
+                      link.gainEpoch[mode] = m_gainEpoch[senderIndex];
+                    }
+                  txGain = link.gainDb[mode];
+                }
+              rxPowerDbm = txPowerDbm + txGain - link.lossDb;
+            }
+          else
+            {
+              delay = m_delay->GetDelay (senderMobility, receiverMobility);
+              if (sendAnt != 0)
+                {
+                  txGain = sendAnt->GetGainDb (senderMobility, receiverMobility, sendAnt->GetAntennaMode ());
+                }
+              rxPowerDbm = m_loss->CalcRxPower (txPowerDbm + txGain, senderMobility, receiverMobility);
+            }
+          if (rxPowerDbm < m_minRxPowerDbm)
+            {
+              NS_LOG_DEBUG ("rxPowerDbm=" << rxPowerDbm << "dbm below cutoff, skip receiver " << j);
+              continue;
+            }
           double rxGain = 0;
           /*
           Ptr<WifiAntennaModel> recvAnt = (*i)->GetAntenna ();
@@ -164,7 +342,8 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
 
           // [2014/09/07] end sugiyama
 
-          Ptr<Packet> copy = packet->Copy ();
+          metadata.rxPowerDbm = rxPowerDbm;
+          m_nSharedDeliveries++;
           Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
           uint32_t dstNode;
           if (dstNetDevice == 0)
@@ -177,21 +356,36 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
             }
           Simulator::ScheduleWithContext (dstNode,
                                           delay, &YansWifiChannel::Receive, this,
-                                          j, copy, rxPowerDbm, txVector, preamble);
+                                          j, packet, metadata, txVector, preamble);
         }
     }
 }
 
 void
-YansWifiChannel::Receive (uint32_t i, Ptr<Packet> packet, double rxPowerDbm,
+YansWifiChannel::Receive (uint32_t i, Ptr<const Packet> packet, YansWifiPhy::RxMetadata metadata,
                           WifiTxVector txVector, WifiPreamble preamble) const
 {
-  m_phyList[i]->StartReceivePacket (packet, rxPowerDbm, txVector, preamble);
+  m_phyList[i]->StartReceivePacket (packet, metadata, txVector, preamble);
 }
 void
-YansWifiChannel::NotifyChangeEndReceive (uint32_t i, Ptr<Packet> packet, double rxPowerDbm, WifiPreamble preamble, Time rxEndTime) const
+YansWifiChannel::NotifyChangeEndReceive (uint32_t i, Ptr<const Packet> packet, YansWifiPhy::RxMetadata metadata, WifiPreamble preamble, Time rxEndTime) const
 {
-  m_phyList[i]->NotifyChangeEndReceive (packet, rxPowerDbm, preamble, rxEndTime);
+  m_phyList[i]->NotifyChangeEndReceive (packet, metadata, preamble, rxEndTime);
+}
+uint64_t
+YansWifiChannel::GetNSharedDeliveries (void) const
+{
+  return m_nSharedDeliveries;
+}
+uint64_t
+YansWifiChannel::GetNCopiesAvoided (void) const
+{
+  uint64_t copies = 0;
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      copies += (*i)->GetNPacketCopies ();
+    }
+  return m_nSharedDeliveries - copies;
 }
 uint32_t
 YansWifiChannel::GetNDevices (void) const
@@ -207,7 +401,258 @@ YansWifiChannel::GetDevice (uint32_t i) const
 void
 YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
+  m_phyIndex[PeekPointer (phy)] = m_phyList.size ();
   m_phyList.push_back (phy);
+  m_spatialIndexValid = false;
+}
+
+void
+YansWifiChannel::SetMaxRange (double maxRange)
+{
+  NS_LOG_FUNCTION (this << maxRange);
+  m_maxRange = maxRange;
+  // The cells are sized by MaxRange.
+  m_spatialIndexValid = false;
+}
+
+double
+YansWifiChannel::GetMaxRange (void) const
+{
+  return m_maxRange;
+}
+
+bool
+YansWifiChannel::IsOutOfRange (Ptr<MobilityModel> senderMobility, Ptr<MobilityModel> receiverMobility) const
+{
+  return m_maxRange > 0.0
+         && senderMobility->GetDistanceFrom (receiverMobility) > m_maxRange;
+}
+
+YansWifiChannel::GridCell
+YansWifiChannel::GetGridCell (const Vector &position) const
+{
+  return GridCell (static_cast<int64_t> (std::floor (position.x / m_maxRange)),
+                   static_cast<int64_t> (std::floor (position.y / m_maxRange)));
+}
+
+void
+YansWifiChannel::ConnectPhys (void) const
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t j = m_connectedPhys; j < m_phyList.size (); j++)
+    {
+      Ptr<MobilityModel> mobility = m_phyList[j]->GetMobility ()->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      m_mobilityIndex[PeekPointer (mobility)] = j;
+      mobility->TraceConnectWithoutContext ("CourseChange",
+                                            MakeCallback (&YansWifiChannel::NotifyCourseChange, this));
+      m_connectedMobilities.push_back (mobility);
+      m_gainEpoch.push_back (1);
+      Ptr<WifiAntennaModel> antenna = m_phyList[j]->GetAntenna ();
+      if (antenna != 0)
+        {
+          LinkBudgetAntennaListener *listener = new LinkBudgetAntennaListener (this, j);
+          antenna->RegisterListener (listener);
+          m_antennaListeners.push_back (listener);
+          m_listenedAntennas.push_back (antenna);
+        }
+    }
+  uint32_t n = m_phyList.size ();
+  if (m_linkBudgetCacheEnabled && m_linkBudgets.size () != n * n)
+    {
+      // move the entries to their index in the larger matrix
+      LinkBudgets linkBudgets (n * n);
+      if (m_linkBudgets.size () == m_connectedPhys * m_connectedPhys)
+        {
+          for (uint32_t s = 0; s < m_connectedPhys; s++)
+            {
+              for (uint32_t r = 0; r < m_connectedPhys; r++)
+                {
+                  linkBudgets[s * n + r] = m_linkBudgets[s * m_connectedPhys + r];
+                }
+            }
+        }
+      m_linkBudgets.swap (linkBudgets);
+    }
+  m_connectedPhys = n;
+}
+
+void
+YansWifiChannel::BuildSpatialIndex (void) const
+{
+  NS_LOG_FUNCTION (this);
+  m_grid.clear ();
+  m_movingPhys.clear ();
+  m_phyCell.resize (m_phyList.size ());
+  for (uint32_t j = 0; j < m_phyList.size (); j++)
+    {
+      Ptr<MobilityModel> mobility = m_phyList[j]->GetMobility ()->GetObject<MobilityModel> ();
+      m_phyCell[j] = GetGridCell (mobility->GetPosition ());
+      m_grid[m_phyCell[j]].push_back (j);
+      if (IsMoving (mobility))
+        {
+          m_movingPhys.insert (j);
+        }
+    }
+  m_spatialIndexValid = true;
+  m_spatialIndexTime = Simulator::Now ();
+}
+
+void
+YansWifiChannel::RefreshSpatialIndex (void) const
+{
+  NS_LOG_FUNCTION (this << m_movingPhys.size ());
+  std::set<uint32_t>::iterator it = m_movingPhys.begin ();
+  while (it != m_movingPhys.end ())
+    {
+      uint32_t j = *it;
+      Ptr<MobilityModel> mobility = m_phyList[j]->GetMobility ()->GetObject<MobilityModel> ();
+      GridCell cell = GetGridCell (mobility->GetPosition ());
+      if (cell != m_phyCell[j])
+        {
+          MovePhy (j, cell);
+        }
+      // A PHY at rest stays in its cell until its next CourseChange.
+      if (IsMoving (mobility))
+        {
+          it++;
+        }
+      else
+        {
+          m_movingPhys.erase (it++);
+        }
+    }
+  m_spatialIndexTime = Simulator::Now ();
+}
+
+bool
+YansWifiChannel::IsMoving (Ptr<const MobilityModel> mobility)
+{
+  Vector velocity = mobility->GetVelocity ();
+  return velocity.x != 0.0 || velocity.y != 0.0;
+}
+
+void
+YansWifiChannel::MovePhy (uint32_t j, GridCell cell) const
+{
+  NS_LOG_DEBUG ("phy " << j << " moves to cell (" << cell.first << "," << cell.second << ")");
+  std::vector<uint32_t> &old = m_grid[m_phyCell[j]];
+  old.erase (std::find (old.begin (), old.end (), j));
+  if (old.empty ())
+    {
+      m_grid.erase (m_phyCell[j]);
+    }
+  m_phyCell[j] = cell;
+  m_grid[cell].push_back (j);
+}
+
+void
+YansWifiChannel::NotifyCourseChange (Ptr<const MobilityModel> mobility) const
+{
+  std::map<const MobilityModel *, uint32_t>::const_iterator it = m_mobilityIndex.find (PeekPointer (mobility));
+  if (it == m_mobilityIndex.end ())
+    {
+      return;
+    }
+  uint32_t j = it->second;
+  if (!m_spatialIndexValid)
+    {
+      return;
+    }
+  GridCell cell = GetGridCell (mobility->GetPosition ());
+  if (cell != m_phyCell[j])
+    {
+      MovePhy (j, cell);
+    }
+  m_movingPhys.insert (j);
+}
+
+void
+YansWifiChannel::GetCandidates (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility,
+                                std::vector<uint32_t> &candidates) const
+{
+  if ((m_connectedPhys < m_phyList.size ()
+       && (m_linkBudgetCacheEnabled || (m_spatialIndexEnabled && m_maxRange > 0.0)))
+      || (m_linkBudgetCacheEnabled && m_linkBudgets.size () != m_phyList.size () * m_phyList.size ()))
+    {
+      ConnectPhys ();
+    }
+  if (!m_spatialIndexEnabled || m_maxRange <= 0.0)
+    {
+      candidates.reserve (m_phyList.size ());
+      for (uint32_t j = 0; j < m_phyList.size (); j++)
+        {
+          candidates.push_back (j);
+        }
+      return;
+    }
+  if (!m_spatialIndexValid)
+    {
+      BuildSpatialIndex ();
+    }
+  else if (m_spatialIndexTime != Simulator::Now ())
+    {
+      RefreshSpatialIndex ();
+    }
+  // The cell size is MaxRange, so every PHY in range is in the 3x3 cells
+  // around the sender.
+  GridCell center = GetGridCell (senderMobility->GetPosition ());
+  for (int64_t dx = -1; dx <= 1; dx++)
+    {
+      for (int64_t dy = -1; dy <= 1; dy++)
+        {
+          Grid::const_iterator cell = m_grid.find (GridCell (center.first + dx, center.second + dy));
+          if (cell != m_grid.end ())
+            {
+              candidates.insert (candidates.end (), cell->second.begin (), cell->second.end ());
+            }
+        }
+    }
+  // Keep the brute-force order so that the Receive events scheduled at
+  // the same time are processed in the same order.
+  std::sort (candidates.begin (), candidates.end ());
+}
+
+void
+YansWifiChannel::NotifyChangeGainPattern (uint32_t i) const
+{
+  NS_LOG_DEBUG ("phy " << i << " has a new gain pattern, drop its cached gains");
+  m_gainEpoch[i]++;
+}
+
+YansWifiChannel::LinkBudget::LinkBudget ()
+  : valid (false),
+    lossDb (0.0)
+{
+}
+
+static bool
+IsSamePosition (const Vector &a, const Vector &b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+YansWifiChannel::LinkBudget &
+YansWifiChannel::GetLinkBudget (uint32_t s, uint32_t r,
+                                Ptr<MobilityModel> senderMobility,
+                                Ptr<MobilityModel> receiverMobility) const
+{
+  NS_ASSERT (s < m_connectedPhys && r < m_connectedPhys);
+  LinkBudget &link = m_linkBudgets[s * m_connectedPhys + r];
+  Vector senderPosition = senderMobility->GetPosition ();
+  Vector receiverPosition = receiverMobility->GetPosition ();
+  if (!link.valid
+      || !IsSamePosition (link.senderPosition, senderPosition)
+      || !IsSamePosition (link.receiverPosition, receiverPosition))
+    {
+      link.valid = true;
+      link.senderPosition = senderPosition;
+      link.receiverPosition = receiverPosition;
+      link.lossDb = -m_loss->CalcRxPower (0.0, senderMobility, receiverMobility);
+      link.delay = m_delay->GetDelay (senderMobility, receiverMobility);
+      std::fill (link.gainEpoch.begin (), link.gainEpoch.end (), 0);
+    }
+  return link;
 }
 
 int64_t
@@ -21,20 +21,27 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include <vector>
+#include <map>
+#include <set>
 #include <stdint.h>
 #include "ns3/packet.h"
+#include "ns3/vector.h"
 #include "wifi-channel.h"
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
 #include "wifi-tx-vector.h"
 #include "ns3/nstime.h"
+#include "ns3/wifi-antenna-model.h"
+#include "yans-wifi-phy.h"
 
 namespace ns3 {
 
 class NetDevice;
+class MobilityModel;
 class PropagationLossModel;
 class PropagationDelayModel;
 class YansWifiPhy;
+class LinkBudgetAntennaListener;
 
 /**
  * \brief A Yans wifi channel
@@ -57,8 +64,26 @@ public:
   virtual ~YansWifiChannel ();
 
   // original method
-  void NotifyChangeEndReceive (uint32_t i, Ptr<Packet> packet, double rxPowerDbm, WifiPreamble preamble, Time rxEndTime) const;
-  void NotifyPostponeSend(Ptr<YansWifiPhy> sender, Ptr<Packet> packet, double rxPowerDbm, WifiTxVector txVector, WifiPreamble preamble, Time rxEndTime);
+  /**
+   * Called by the antenna listener of the i-th PHY when the gain pattern
+   * of its antenna changes. The cached gains of this PHY are dropped.
+   *
+   * \param i index of the PHY in the PHY list
+   */
+  void NotifyChangeGainPattern (uint32_t i) const;
+  void NotifyChangeEndReceive (uint32_t i, Ptr<const Packet> packet, YansWifiPhy::RxMetadata metadata, WifiPreamble preamble, Time rxEndTime) const;
+  void NotifyPostponeSend(Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, const FdTxMetadata &fdMetadata, double rxPowerDbm, WifiTxVector txVector, WifiPreamble preamble, Time rxEndTime);
+  /**
+   * \return the number of times a packet was handed to a receiver
+   *         without copying it
+   */
+  uint64_t GetNSharedDeliveries (void) const;
+  /**
+   * \return the number of packet copies saved by sharing the packets,
+   *         i.e. the shared deliveries which the receivers did not have
+   *         to copy later on
+   */
+  uint64_t GetNCopiesAvoided (void) const;
   
   // inherited from Channel.
   virtual uint32_t GetNDevices (void) const;
@@ -83,6 +108,7 @@ public:
   /**
    * \param sender the device from which the packet is originating.
    * \param packet the packet to send
+   * \param fdMetadata the full-duplex information delivered with the packet
    * \param txPowerDbm the tx power associated to the packet
    * \param txVector the TXVECTOR associated to the packet
    * \param preamble the preamble associated to the packet
@@ -92,7 +118,7 @@ public:
    * delivers packets only between PHYs with the same m_channelNumber,
    * e.g. PHYs that are operating on the same channel.
    */
-  void Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm,
+  void Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, const FdTxMetadata &fdMetadata, double txPowerDbm,
              WifiTxVector txVector, WifiPreamble preamble) const;
 
  /**
@@ -105,7 +131,18 @@ public:
   */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \param maxRange the distance (m) beyond which receivers are culled,
+   *        zero disables the cutoff. This is also the grid cell size.
+   */
+  void SetMaxRange (double maxRange);
+  /**
+   * \return the distance (m) beyond which receivers are culled
+   */
+  double GetMaxRange (void) const;
+
 private:
+  virtual void DoDispose (void);
   //YansWifiChannel& operator = (const YansWifiChannel &);
   //YansWifiChannel (const YansWifiChannel &);
 
@@ -119,18 +156,144 @@ private:
    * bit of the packet has arrived.
    *
    * \param i index of the corresponding YansWifiPhy in the PHY list
-   * \param packet the packet being sent
-   * \param rxPowerDbm the received power of the packet
+   * \param packet the packet being sent, shared by all the receivers
+   * \param metadata the received power and full-duplex fields of the packet
    * \param txVector the TXVECTOR of the packet
    * \param preamble the type of preamble being used to send the packet
    */
-  void Receive (uint32_t i, Ptr<Packet> packet, double rxPowerDbm,
+  void Receive (uint32_t i, Ptr<const Packet> packet, YansWifiPhy::RxMetadata metadata,
                 WifiTxVector txVector, WifiPreamble preamble) const;
 
+  /**
+   * A cell of the spatial index, i.e. the (x, y) position divided by
+   * the MaxRange attribute and rounded down.
+   */
+  typedef std::pair<int64_t, int64_t> GridCell;
+  /**
+   * Map from a grid cell to the indices (in m_phyList) of the PHYs inside it.
+   */
+  typedef std::map<GridCell, std::vector<uint32_t> > Grid;
+
+  /**
+   * \param sender the transmitting PHY
+   * \param senderMobility the mobility model of the transmitting PHY
+   * \param candidates filled with the indices (in m_phyList) of the PHYs
+   *        which may hear the sender, in increasing order
+   *
+   * Without the spatial index (or without a MaxRange) every PHY is a
+   * candidate. With it, only the PHYs of the 3x3 cells around the sender
+   * are returned. The caller must still check the exact distance.
+   */
+  void GetCandidates (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility,
+                      std::vector<uint32_t> &candidates) const;
+  /**
+   * \param senderMobility the mobility model of the transmitting PHY
+   * \param receiverMobility the mobility model of the receiving PHY
+   * \return true if the receiver is farther than the MaxRange attribute.
+   */
+  bool IsOutOfRange (Ptr<MobilityModel> senderMobility, Ptr<MobilityModel> receiverMobility) const;
+  GridCell GetGridCell (const Vector &position) const;
+  /**
+   * Connect to the CourseChange trace and to the antenna of every PHY
+   * added since the last call, and grow the link budget matrix.
+   */
+  void ConnectPhys (void) const;
+  /**
+   * (Re)build the spatial index from the current PHY positions.
+   */
+  void BuildSpatialIndex (void) const;
+  /**
+   * Move the moving PHYs whose current position left their grid cell.
+   * The mobility models do not fire CourseChange while they move along a
+   * course (e.g. ConstantVelocityMobilityModel), so this is done once
+   * per simulation time step before the grid is used. Only the PHYs in
+   * m_movingPhys are looked at; those found at rest leave the set.
+   */
+  void RefreshSpatialIndex (void) const;
+  /**
+   * \param mobility a mobility model
+   * \return true if it moves in the (x, y) plane of the grid
+   */
+  static bool IsMoving (Ptr<const MobilityModel> mobility);
+  /**
+   * \param j index of the PHY in the PHY list
+   * \param cell the new grid cell of the PHY
+   */
+  void MovePhy (uint32_t j, GridCell cell) const;
+  /**
+   * Disconnect from the CourseChange traces, unregister the listeners
+   * from the PHY antennas and delete them.
+   */
+  void DisconnectPhys (void);
+  /**
+   * Move the PHY of the given mobility model to its new grid cell and
+   * watch it in RefreshSpatialIndex from now on.
+   *
+   * \param mobility the mobility model whose course changed
+   */
+  void NotifyCourseChange (Ptr<const MobilityModel> mobility) const;
+
+  /**
+   * Path loss, propagation delay and transmit gains between two PHYs.
+   * An entry is valid while both ends are at the positions stored in
+   * it (CourseChange is not fired by every move, so the positions are
+   * compared); a gain is valid while its epoch is the current gain
+   * epoch of the sender (0 means not computed).
+   */
+  struct LinkBudget
+  {
+    LinkBudget ();
+    bool valid;              //!< false until the entry is computed
+    Vector senderPosition;   //!< position of the sender
+    Vector receiverPosition; //!< position of the receiver
+    double lossDb;          //!< path loss (dB)
+    Time delay;             //!< propagation delay
+    std::vector<uint32_t> gainEpoch; //!< gain epoch per sender antenna mode
+    std::vector<double> gainDb;      //!< tx gain (dB) per sender antenna mode
+  };
+  /**
+   * Link budgets of the connected PHYs, the one of (s, r) at
+   * s * m_connectedPhys + r.
+   */
+  typedef std::vector<LinkBudget> LinkBudgets;
+
+  /**
+   * \param s index of the sender in the PHY list
+   * \param r index of the receiver in the PHY list
+   * \param senderMobility the mobility model of the sender
+   * \param receiverMobility the mobility model of the receiver
+   * \return the link budget of (s, r), computed if missing or stale
+   */
+  LinkBudget & GetLinkBudget (uint32_t s, uint32_t r,
+                              Ptr<MobilityModel> senderMobility,
+                              Ptr<MobilityModel> receiverMobility) const;
+
 
   PhyList m_phyList; //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss; //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay; //!< Propagation delay model
+
+  bool m_spatialIndexEnabled; //!< Use the grid index to select the receivers
+  double m_maxRange;          //!< Receivers beyond this distance (m) are culled, 0 disables
+  double m_minRxPowerDbm;     //!< Receivers below this power are culled
+
+  mutable bool m_spatialIndexValid;                     //!< false when m_grid must be rebuilt
+  mutable Time m_spatialIndexTime;                      //!< time of the last refresh of m_grid
+  mutable Grid m_grid;                                  //!< PHY indices per grid cell
+  mutable std::vector<GridCell> m_phyCell;              //!< current grid cell of each PHY
+  mutable std::map<const MobilityModel *, uint32_t> m_mobilityIndex; //!< PHY index of each connected mobility model
+  mutable std::vector<Ptr<MobilityModel> > m_connectedMobilities;   //!< mobility models connected to NotifyCourseChange
+  mutable std::set<uint32_t> m_movingPhys;              //!< PHYs moving or with a course change since the last refresh
+
+  bool m_linkBudgetCacheEnabled;                  //!< Cache loss, delay and gain per link
+  std::map<const YansWifiPhy *, uint32_t> m_phyIndex; //!< index of each PHY in m_phyList
+  mutable uint32_t m_connectedPhys;               //!< number of PHYs passed to ConnectPhys
+  mutable LinkBudgets m_linkBudgets;              //!< cached link budgets
+  mutable std::vector<uint32_t> m_gainEpoch;      //!< bumped when the antenna gain pattern of a PHY changes
+
+  mutable uint64_t m_nSharedDeliveries; //!< packets handed to a receiver without a copy
+  mutable std::vector<LinkBudgetAntennaListener *> m_antennaListeners; //!< listeners registered on the PHY antennas
+  mutable std::vector<Ptr<WifiAntennaModel> > m_listenedAntennas;      //!< antenna of each listener
 };
 
 } // namespace ns3
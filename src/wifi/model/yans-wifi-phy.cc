@@ -28,9 +28,6 @@
 #include "wifi-phy-state-helper.h"
 #include "error-rate-model.h"
 #include "wifi-mac-trailer.h"
-#include "busytone-tag.h"
-#include "secondary-tag.h"
-#include "source-tag.h"
 #include "ns3/simulator.h"
 #include "ns3/packet.h"
 #include "ns3/assert.h"
@@ -169,24 +166,65 @@ YansWifiPhy::GetTypeId (void)
                    MakeBooleanAccessor (&YansWifiPhy::GetChannelBonding,
                                         &YansWifiPhy::SetChannelBonding),
                    MakeBooleanChecker ())
+    .AddAttribute ("EventLifetime",
+                   "How long after its end the last event of a transmitter is "
+                   "kept for postpone notifications before it may be reclaimed.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&YansWifiPhy::SetEventLifetime,
+                                     &YansWifiPhy::GetEventLifetime),
+                   MakeTimeChecker ())
+    .AddAttribute ("ChunkSuccessRateResolution",
+                   "SNIR resolution (dB) of the chunk success rate cache; the "
+                   "cached rate is exact for an SNIR within half of it. 0 disables the cache.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&YansWifiPhy::SetChunkSuccessRateResolution,
+                                       &YansWifiPhy::GetChunkSuccessRateResolution),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("FrameStats",
+                   "Whether the transmitted and received frames are counted per class "
+                   "(primary, secondary, busytone, ack, other).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiPhy::m_frameStats),
+                   MakeBooleanChecker ())
+    .AddAttribute ("FrameStatsSmallFrameSize",
+                   "Data frames up to this size (bytes) are counted as other frames.",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&YansWifiPhy::m_smallFrameSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("LiveEvents",
+                     "The number of events indexed by transmitter address.",
+                     MakeTraceSourceAccessor (&YansWifiPhy::m_liveEvents))
+    .AddTraceSource ("LiveEventsHighWater",
+                     "The largest number of events ever indexed by transmitter address.",
+                     MakeTraceSourceAccessor (&YansWifiPhy::m_maxLiveEvents))
+    .AddTraceSource ("FdTxBegin",
+                     "A packet has begun transmitting, with its full-duplex metadata.",
+                     MakeTraceSourceAccessor (&YansWifiPhy::m_fdTxBeginTrace))
 
 
   ;
   return tid;
 }
 
+YansWifiPhy::RxMetadata::RxMetadata ()
+  : rxPowerDbm (0)
+{
+}
+
 YansWifiPhy::YansWifiPhy ()
   :  m_channelNumber (1),
      m_headerErrorFlg (false),
      m_endRxEvent (),
      m_endRxHeaderEvent(),
-     m_channelStartingFrequency (0)
+     m_channelStartingFrequency (0),
+     m_nPacketCopies (0)
 {
   NS_LOG_FUNCTION (this);
   m_event = NULL;
   m_random = CreateObject<UniformRandomVariable> ();
   m_state = CreateObject<WifiPhyStateHelper> ();
   m_geo = CreateObject<GeographyTable> ();
+  ResetFrameStats ();
 }
 
 YansWifiPhy::~YansWifiPhy ()
@@ -470,21 +508,20 @@ YansWifiPhy::SetReceiveErrorCallback (RxErrorCallback callback)
   m_state->SetReceiveErrorCallback (callback);
 }
 void
-YansWifiPhy::NotifyChangeEndReceive (Ptr<Packet> packet,
-				     double rxPowerDbm,
+YansWifiPhy::NotifyChangeEndReceive (Ptr<const Packet> packet,
+				     RxMetadata metadata,
                                      enum WifiPreamble preamble,
                                      Time rxEndTime)
 {
   NS_LOG_FUNCTION (this << packet << preamble <<
 		   " rxEndTime=" << rxEndTime <<
-		   " db=" <<rxPowerDbm + m_rxGainDb);
+		   " db=" << metadata.rxPowerDbm + m_rxGainDb);
 
-  rxPowerDbm += m_rxGainDb;
+  double rxPowerDbm = metadata.rxPowerDbm + m_rxGainDb;
   double rxPowerW = DbmToW (rxPowerDbm);
 
   WifiMacHeader hdr;
-  Ptr<Packet> tmp_packet = packet->Copy();
-  tmp_packet->RemoveHeader (hdr);
+  packet->PeekHeader (hdr);
   Mac48Address addr2 = hdr.GetAddr2();
   if(m_event == NULL)
     {
@@ -510,6 +547,7 @@ YansWifiPhy::NotifyChangeEndReceive (Ptr<Packet> packet,
       m_endRxEvent = Simulator::Schedule (rxEndTime - Simulator::Now(),
                                           &YansWifiPhy::EndReceive, this,
                                           packet,
+                                          metadata,
                                           m_event);
 
       m_state->PostponeRx(rxEndTime);
@@ -526,25 +564,19 @@ YansWifiPhy::NotifyChangeEndReceive (Ptr<Packet> packet,
 }
 
 void
-YansWifiPhy::StartReceivePacket (Ptr<Packet> packet,
-                                 double rxPowerDbm,
+YansWifiPhy::StartReceivePacket (Ptr<const Packet> packet,
+                                 RxMetadata metadata,
                                  WifiTxVector txVector,
                                  enum WifiPreamble preamble)
 {
-  NS_LOG_FUNCTION (this << packet << rxPowerDbm << txVector.GetMode()<< preamble);
+  NS_LOG_FUNCTION (this << packet << metadata.rxPowerDbm << txVector.GetMode()<< preamble);
 
-  BusytoneTag busytone;
-  bool flgBusytone = ConstCast<Packet>(packet)->PeekPacketTag (busytone);
-  uint32_t busytoneSize = 0;
-  if(flgBusytone)
-    {
-      busytoneSize = busytone.GetDataSize();
-    }
-  NS_LOG_DEBUG("packetSize" << packet->GetSize() << "busytoneSize" << busytoneSize);
+  Time busytoneDuration = metadata.tx.busytoneDuration;
+  NS_LOG_DEBUG("packetSize" << packet->GetSize() << "busytoneDuration" << busytoneDuration);
   
-  rxPowerDbm += m_rxGainDb;
+  double rxPowerDbm = metadata.rxPowerDbm + m_rxGainDb;
   double rxPowerW = DbmToW (rxPowerDbm);
-  Time rxDuration = CalculateTxDuration (packet->GetSize () + busytoneSize, txVector, preamble);
+  Time rxDuration = CalculateTxDuration (packet->GetSize (), txVector, preamble) + busytoneDuration;
   WifiMode txMode=txVector.GetMode();
   Time endRx = Simulator::Now () + rxDuration;
 
@@ -554,9 +586,6 @@ YansWifiPhy::StartReceivePacket (Ptr<Packet> packet,
   Time rxHeaderDuration = CalculateTxDuration (hdr.GetSize(), txVector, preamble);
   Time endHeader = Simulator::Now () + rxHeaderDuration;
 
-  SourceTag sourceTag;
-  packet->PeekPacketTag (sourceTag);
-  
   NS_LOG_DEBUG("headerEvent:" << " start=" << Simulator::Now() << " end=" << endHeader);
   Ptr<InterferenceHelper::Event> headerEvent;
   headerEvent = m_interference.Add (hdr.GetSize(),
@@ -566,7 +595,7 @@ YansWifiPhy::StartReceivePacket (Ptr<Packet> packet,
 				    endHeader,
 				    rxPowerW,
 				    txVector,
-				    sourceTag.GetAddress ());
+				    metadata.tx.source);
 
   NS_LOG_DEBUG("payloadEvent:" << " start=" << endHeader << " end=" << endRx);
   Ptr<InterferenceHelper::Event> payloadEvent;
@@ -578,6 +607,7 @@ YansWifiPhy::StartReceivePacket (Ptr<Packet> packet,
 				     rxPowerW,
 				     txVector,
 				     hdr.GetAddr2());
+  UpdateLiveEvents ();
   
   switch (m_state->GetState ())
     {
@@ -640,12 +670,14 @@ YansWifiPhy::StartReceivePacket (Ptr<Packet> packet,
 						  &YansWifiPhy::EndReceive,
 						  this,
 						  packet,
+						  metadata,
 						  payloadEvent);
 
 	      m_endRxHeaderEvent = Simulator::Schedule (rxHeaderDuration,
 							&YansWifiPhy::EndReceiveHeader,
 							this,
 							packet,
+							metadata,
 							headerEvent,
 							txVector);
 	      // set address, rx power and event
@@ -689,15 +721,16 @@ maybeCcaBusy:
 void
 YansWifiPhy::SendPacket (Ptr<const Packet> packet, WifiMode txMode, WifiPreamble preamble, WifiTxVector txVector)
 {
-  NS_LOG_FUNCTION (this << packet << txMode << preamble << (uint32_t)txVector.GetTxPowerLevel());
-  BusytoneTag busytone;
-  bool flgBusytone = ConstCast<Packet>(packet)->PeekPacketTag (busytone);
-  uint32_t busytoneSize = 0;
-  if(flgBusytone)
-    {
-      busytoneSize = busytone.GetDataSize();
-    }
-  NS_LOG_INFO (this << "packetSize" << packet->GetSize() << "busytoneSize" << busytoneSize);
+  SendPacket (packet, txMode, preamble, txVector, FdTxMetadata ());
+}
+
+void
+YansWifiPhy::SendPacket (Ptr<const Packet> packet, WifiMode txMode, WifiPreamble preamble, WifiTxVector txVector,
+                         const FdTxMetadata &metadata)
+{
+  NS_LOG_FUNCTION (this << packet << txMode << preamble << (uint32_t)txVector.GetTxPowerLevel() << metadata);
+  Time busytoneDuration = metadata.busytoneDuration;
+  NS_LOG_INFO (this << "packetSize" << packet->GetSize() << "busytoneDuration" << busytoneDuration);
   /* Transmission can happen if:
    *  - we are syncing on a packet. It is the responsability of the
    *    MAC layer to avoid doing this but the PHY does nothing to
@@ -707,7 +740,8 @@ YansWifiPhy::SendPacket (Ptr<const Packet> packet, WifiMode txMode, WifiPreamble
   NS_ASSERT (!m_state->IsStateTx () && !m_state->IsStateFd () &&
              !m_state->IsStateSwitching ());
 
-  Time txDuration = CalculateTxDuration (packet->GetSize () + busytoneSize, txVector, preamble);
+  Time frameDuration = CalculateTxDuration (packet->GetSize (), txVector, preamble);
+  Time txDuration = frameDuration + busytoneDuration;
   /*
   if (m_state->IsStateRx ())
     {
@@ -719,13 +753,32 @@ YansWifiPhy::SendPacket (Ptr<const Packet> packet, WifiMode txMode, WifiPreamble
   m_sendingTxVector = txVector;
   m_sendingPreamble = preamble;
   m_sendingPowerDbm = GetPowerDbm ( txVector.GetTxPowerLevel()) + m_txGainDb;
+  m_sendingMetadata = metadata;
+  if (m_antenna != 0)
+    {
+      m_sendingMetadata.antennaSector = m_antenna->GetAntennaMode ();
+    }
   
   NotifyTxBegin (packet);
+  m_fdTxBeginTrace (packet, m_sendingMetadata);
+  if (m_frameStats)
+    {
+      WifiMacHeader hdr;
+      packet->PeekHeader (hdr);
+      m_txFrames[ClassifyFrame (hdr, packet->GetSize (), metadata.secondary)]++;
+    }
   uint32_t dataRate500KbpsUnits = txVector.GetMode().GetDataRate () * txVector.GetNss() / 500000;
   bool isShortPreamble = (WIFI_PREAMBLE_SHORT == preamble);
   NotifyMonitorSniffTx (packet, (uint16_t)GetChannelFrequencyMhz (), GetChannelNumber (), dataRate500KbpsUnits, isShortPreamble, txVector.GetTxPowerLevel());
   m_state->SwitchToTx (txDuration, packet, txVector.GetMode(), preamble,  txVector.GetTxPowerLevel());
-  m_channel->Send (this, packet, GetPowerDbm ( txVector.GetTxPowerLevel()) + m_txGainDb, txVector, preamble);
+  if (busytoneDuration.IsStrictlyPositive ())
+    {
+      WifiMacHeader hdr;
+      packet->PeekHeader (hdr);
+      // the whole busytone frame only pads the channel
+      m_state->NotifyTxPadding (hdr.IsBusy () ? Simulator::Now () : Simulator::Now () + frameDuration);
+    }
+  m_channel->Send (this, packet, m_sendingMetadata, GetPowerDbm ( txVector.GetTxPowerLevel()) + m_txGainDb, txVector, preamble);
 }
 
 uint32_t
@@ -978,12 +1031,11 @@ YansWifiPhy::GetPrimaryTransmissionEndTime()
 }
 
 void
-YansWifiPhy::EndReceive (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> event)
+YansWifiPhy::EndReceive (Ptr<const Packet> packet, RxMetadata metadata, Ptr<InterferenceHelper::Event> event)
 {
 
   WifiMacHeader hdr;
-  Ptr<Packet> tmp_packet = packet->Copy();
-  tmp_packet->RemoveHeader (hdr);
+  packet->PeekHeader (hdr);
   if(hdr.GetType() == WIFI_MAC_DATA_NULL)
     {
       NS_LOG_INFO ("Receive Error Busytone");
@@ -1001,83 +1053,65 @@ YansWifiPhy::EndReceive (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> even
 
   struct InterferenceHelper::SnrPer snrPer;
 
-  // remove seconary tag
-  SecondaryTag secondary;
-  if(ConstCast<Packet>(packet)->PeekPacketTag (secondary))
-    {
-      ConstCast<Packet>(packet)->RemovePacketTag (secondary);
-    }
-
-  // remove busytone tag
-  BusytoneTag busytone;
-  bool flgBusytone = ConstCast<Packet>(packet)->PeekPacketTag (busytone);
-  uint32_t busytoneSize = 0;
-  if(flgBusytone)
-    {
-      busytoneSize = busytone.GetDataSize();
-    }
+  Time busytoneDuration = metadata.tx.busytoneDuration;
 
-  snrPer = m_interference.CalculateSnrPerPayload (event, busytoneSize);
+  snrPer = m_interference.CalculateSnrPerPayload (event, busytoneDuration);
   m_interference.NotifyRxEnd ();
+  UpdateLiveEvents ();
 
   double randomValue = m_random->GetValue ();
   NS_LOG_DEBUG ("mode=" << (event->GetPayloadMode ().GetDataRate ()) <<
                 "snr=" << snrPer.snr <<
 		"per=" << snrPer.per <<
-		"busytoneSize" << busytoneSize <<
-		"packetSize=" << packet->GetSize () + busytoneSize);
+		"busytoneDuration" << busytoneDuration <<
+		"packetSize=" << packet->GetSize ());
+
+  // the packet is shared with the other receivers: the MAC gets its
+  // own copy, and the full-duplex metadata through the phy
+  Ptr<Packet> copy = packet->Copy ();
+  m_nPacketCopies++;
 
   if (randomValue > snrPer.per && !m_headerErrorFlg)
     {
-      if(flgBusytone)
-	{
-	  packet->RemovePacketTag(busytone);
-	}
-      NotifyRxEnd (packet);
+      NotifyRxEnd (copy);
       uint32_t dataRate500KbpsUnits = event->GetPayloadMode ().GetDataRate () * event->GetTxVector().GetNss()/ 500000;
       bool isShortPreamble = (WIFI_PREAMBLE_SHORT == event->GetPreambleType ());
       double signalDbm = RatioToDb (event->GetRxPowerW ()) + 30;
       double noiseDbm = RatioToDb (event->GetRxPowerW () / snrPer.snr) - GetRxNoiseFigure () + 30;
-      NotifyMonitorSniffRx (packet, (uint16_t)GetChannelFrequencyMhz (), GetChannelNumber (), dataRate500KbpsUnits, isShortPreamble, signalDbm, noiseDbm);
-      m_state->SwitchFromRxEndOk (packet, snrPer.snr, event->GetPayloadMode (), event->GetPreambleType ());
+      NotifyMonitorSniffRx (copy, (uint16_t)GetChannelFrequencyMhz (), GetChannelNumber (), dataRate500KbpsUnits, isShortPreamble, signalDbm, noiseDbm);
+      SetReceivingMetadata (metadata.tx);
+      if (m_frameStats)
+        {
+          m_rxFrames[ClassifyFrame (hdr, packet->GetSize (), metadata.tx.secondary)]++;
+        }
+      m_state->SwitchFromRxEndOk (copy, snrPer.snr, event->GetPayloadMode (), event->GetPreambleType ());
     }
   else
     {
       /* failure. */
-      if(flgBusytone)
-	{
-	  packet->RemovePacketTag(busytone);
-	}
-      NotifyRxDrop (packet);
-      m_state->SwitchFromRxEndError (packet, snrPer.snr);
+      NotifyRxDrop (copy);
+      m_state->SwitchFromRxEndError (copy, snrPer.snr);
     }
   m_headerErrorFlg = false;
 }
 
 void
-YansWifiPhy::EndReceiveHeader (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> event, WifiTxVector txVector)
+YansWifiPhy::EndReceiveHeader (Ptr<const Packet> packet, RxMetadata metadata, Ptr<InterferenceHelper::Event> event, WifiTxVector txVector)
 {
   WifiMacHeader hdr;
-  Ptr<Packet> tmp_packet = packet->Copy();
-  tmp_packet->RemoveHeader (hdr);
+  packet->PeekHeader (hdr);
   NS_ASSERT (IsStateRx () || IsStateFd ());
   NotifyRxHeaderEnd (packet);
-  WifiMacType type = hdr.GetType();
   Mac48Address addr1 = hdr.GetAddr1();
   Mac48Address addr2 = hdr.GetAddr2();
-  BusytoneTag busytone;
-  SecondaryTag secondary;
-  bool isBusytone = ConstCast<Packet>(packet)->PeekPacketTag (busytone);
-  bool isSecondary = ConstCast<Packet>(packet)->PeekPacketTag (secondary);
-  uint32_t busytoneSize = 0;
-
+  bool isBusytone = metadata.tx.busytoneDuration.IsStrictlyPositive ();
+  bool isSecondary = metadata.tx.secondary;
+  Time busytoneDuration = metadata.tx.busytoneDuration;
 
-  if(isBusytone)
-    {
-      busytoneSize = busytone.GetDataSize();
-    }
-  Time timeOffset = MicroSeconds(GetPayloadDurationMicroSeconds(packet->GetSize() + busytoneSize - hdr.GetSize(), txVector));
-  timeOffset -= MicroSeconds(4);
+  // time left until the end of the frame and its padding
+  WifiPreamble preamble = event->GetPreambleType ();
+  Time timeOffset = CalculateTxDuration (packet->GetSize (), txVector, preamble) + busytoneDuration
+    - CalculateTxDuration (hdr.GetSize (), txVector, preamble);
 
   NS_LOG_FUNCTION(this << hdr << event << hdr.GetSize() << isBusytone << m_state->GetState () <<
 		  " isquemp"<< m_macLow->GetDcaTxop()->IsQueueEmpty() <<
@@ -1090,8 +1124,8 @@ YansWifiPhy::EndReceiveHeader (Ptr<Packet> packet, Ptr<InterferenceHelper::Event
   NS_LOG_DEBUG ("mode=" << (event->GetPayloadMode ().GetDataRate ()) <<
                 "snr=" << snrPer.snr <<
 		"per=" << snrPer.per <<
-		"busytoneSize=" << busytoneSize <<
-		"packetSize=" << packet->GetSize () + busytoneSize);
+		"busytoneDuration=" << busytoneDuration <<
+		"packetSize=" << packet->GetSize ());
 
   if (randomValue <= snrPer.per)
     {
@@ -1100,9 +1134,9 @@ YansWifiPhy::EndReceiveHeader (Ptr<Packet> packet, Ptr<InterferenceHelper::Event
       return;
     }
 
-  if(type != WIFI_MAC_DATA || addr1.IsBroadcast())
+  if(!hdr.IsData () || addr1.IsBroadcast())
     {
-      NS_LOG_DEBUG("header is broadcast or data type is not WIFI_MAC_DATA");
+      NS_LOG_DEBUG("header is broadcast or not a data frame");
       return;
     }
 
@@ -1119,14 +1153,17 @@ YansWifiPhy::EndReceiveHeader (Ptr<Packet> packet, Ptr<InterferenceHelper::Event
           m_primaryTransmissionEndTime = Simulator::Now () + timeOffset;
           SetReceivingAddress4 (addr2);
 
-	  if(m_macLow->GetDcaTxop ()->IsSendBusytoneGranted ())
+	  // only the DCF queue answers with a secondary transmission, see
+	  // MacLow::SetDcaTxop
+	  Ptr<DcaTxop> dca = m_macLow->GetDcaTxop ();
+	  if(dca->IsSendBusytoneGranted ())
 	    {
-	      SendBusytone(packet, txVector);
+	      SendBusytone(packet, timeOffset);
 	      return;
 	    }
 	  else
 	    {
-	      m_macLow->GetDcaTxop ()->NotifySecondaryTransmissionRequested ();
+	      dca->NotifySecondaryTransmissionRequested ();
 	      return;
 	    }
 	}
@@ -1145,14 +1182,12 @@ YansWifiPhy::EndReceiveHeader (Ptr<Packet> packet, Ptr<InterferenceHelper::Event
           if(secondaryTransmissonEndTime > m_state->GetLastTxEndTime() + MicroSeconds(10))
             {
               NS_LOG_INFO("End Time of primary transmission < Secondary Transmission");
-              Ptr<Packet> copy = m_sendingPacket->Copy();
               Time duration = secondaryTransmissonEndTime - m_state->GetLastTxEndTime();
-              uint32_t pktSize = GetPacketSizeFromDuration (duration, m_sendingTxVector);
-              BusytoneTag addBusytone;
-	      NS_LOG_DEBUG("addBusytoneSize=" << pktSize << " duration " << duration);
-              addBusytone.SetDataSize(pktSize);
-	      copy->AddPacketTag(addBusytone);
-	      m_channel->NotifyPostponeSend(this, copy, m_sendingPowerDbm, m_sendingTxVector, m_sendingPreamble,
+	      NS_LOG_DEBUG("addBusytoneDuration=" << duration);
+              // the whole extension is padding on top of the one already sent
+              FdTxMetadata postponed = m_sendingMetadata;
+              postponed.busytoneDuration += duration;
+	      m_channel->NotifyPostponeSend(this, m_sendingPacket, postponed, m_sendingPowerDbm, m_sendingTxVector, m_sendingPreamble,
 					    secondaryTransmissonEndTime);
               m_state->PostponeTx(secondaryTransmissonEndTime);
 
@@ -1174,22 +1209,13 @@ YansWifiPhy::AssignStreams (int64_t stream)
 }
 
 void
-YansWifiPhy::SendBusytone(Ptr<const Packet> packet, WifiTxVector txVector)
+YansWifiPhy::SendBusytone(Ptr<const Packet> packet, Time duration)
 {
-  NS_LOG_FUNCTION (this << packet);
+  NS_LOG_FUNCTION (this << packet << duration);
   // Make Header
   WifiMacHeader tmpHdr;
   packet->PeekHeader (tmpHdr);
   Mac48Address addr1 = tmpHdr.GetAddr2();
-  BusytoneTag busytone;
-  bool flgBusytone = ConstCast<Packet>(packet)->PeekPacketTag (busytone);
-  uint32_t busytoneSize = 0;
-
-  if(flgBusytone)
-    {
-      busytoneSize = busytone.GetDataSize();
-    }
-  Time timeOffset = MicroSeconds(GetPayloadDurationMicroSeconds(packet->GetSize() + busytoneSize - tmpHdr.GetSize(), txVector));
   WifiMacHeader busytoneHdr;
   busytoneHdr.SetType (WIFI_MAC_CTL_BUSY);
   busytoneHdr.SetDsNotFrom ();
@@ -1204,40 +1230,28 @@ YansWifiPhy::SendBusytone(Ptr<const Packet> packet, WifiTxVector txVector)
   WifiPreamble preamble;
   preamble=WIFI_PREAMBLE_LONG;
 
-  // Calculate packet size
+  // The busytone is an empty frame padded until the end of the primary
+  // transmission; 4 is fcs size
   Ptr<Packet> dammy_packet = Create<Packet>(0);
   WifiTxVector ownTxVector = m_macLow->GetDataTxVector (dammy_packet, &busytoneHdr);
-  Time timeOffsetWoPlcp = timeOffset - CalculatePlcpDuration (ownTxVector, preamble);
-  timeOffsetWoPlcp -= MicroSeconds (4);
-  if(timeOffsetWoPlcp <= 0)
+  Time frameDuration = CalculateTxDuration (busytoneHdr.GetSize () + 4, ownTxVector, preamble);
+  Time busytoneDuration = GetBusytoneDuration (duration - frameDuration, ownTxVector);
+  if (!busytoneDuration.IsStrictlyPositive ())
     {
-      NS_LOG_DEBUG("Do not send Busytone when packete size is smaller than heder size.");
+      NS_LOG_DEBUG("Do not send Busytone when the primary transmission ends before its header.");
       return;
     }
-  uint32_t pktSize = GetPacketSizeFromDuration (timeOffsetWoPlcp, ownTxVector);
-  
-  // 4 is fcs size
-  if(pktSize > (busytoneHdr.GetSize() + 4))
-    {
 
-      Ptr<Packet> busytone;
-      busytone = Create<Packet>(pktSize - (busytoneHdr.GetSize() + 4));
+  Ptr<Packet> busytone = Create<Packet>(0);
+  FdTxMetadata metadata;
+  metadata.source = m_macLow->GetAddress();
+  metadata.busytoneDuration = busytoneDuration;
 
-      SourceTag sourceTag;
-      sourceTag.SetAddress (m_macLow->GetAddress());
-      busytone->AddPacketTag (sourceTag);
-      
-      busytoneHdr.SetDuration (Time(0));
-      busytone->AddHeader (busytoneHdr);
-      WifiMacTrailer fcs;
-      busytone->AddTrailer (fcs);
-      NS_LOG_DEBUG("SendBusyTone pktSize=" << pktSize << " duration=" << timeOffset << " duration w/o plcp=" << timeOffsetWoPlcp << " Hdr="<< busytoneHdr.GetSize());
-      SendPacket (busytone, ownTxVector.GetMode(), preamble, ownTxVector);
-    }
-  else
-    {
-      NS_LOG_DEBUG("Do not send Busytone when packete size is smaller than heder size.");
-    }
+  busytone->AddHeader (busytoneHdr);
+  WifiMacTrailer fcs;
+  busytone->AddTrailer (fcs);
+  NS_LOG_DEBUG("SendBusyTone duration=" << duration << " frame=" << frameDuration << " padding=" << busytoneDuration << " Hdr="<< busytoneHdr.GetSize());
+  SendPacket (busytone, ownTxVector.GetMode(), preamble, ownTxVector, metadata);
 }
 
 void
@@ -1331,6 +1345,96 @@ YansWifiPhy::SetChannelBonding(bool channelbonding)
   m_channelBonding= channelbonding;
 }
 
+uint64_t
+YansWifiPhy::GetNPacketCopies (void) const
+{
+  return m_nPacketCopies;
+}
+
+uint64_t
+YansWifiPhy::GetNTxFrames (enum FrameClass frameClass) const
+{
+  NS_ASSERT (frameClass < FRAME_CLASSES);
+  return m_txFrames[frameClass];
+}
+
+uint64_t
+YansWifiPhy::GetNRxFrames (enum FrameClass frameClass) const
+{
+  NS_ASSERT (frameClass < FRAME_CLASSES);
+  return m_rxFrames[frameClass];
+}
+
+void
+YansWifiPhy::ResetFrameStats (void)
+{
+  for (uint32_t i = 0; i < FRAME_CLASSES; i++)
+    {
+      m_txFrames[i] = 0;
+      m_rxFrames[i] = 0;
+    }
+}
+
+enum YansWifiPhy::FrameClass
+YansWifiPhy::ClassifyFrame (const WifiMacHeader &hdr, uint32_t size, bool secondary) const
+{
+  switch (hdr.GetType ())
+    {
+    case WIFI_MAC_DATA_NULL:
+    case WIFI_MAC_DATA_NULL_CFACK:
+    case WIFI_MAC_DATA_NULL_CFPOLL:
+    case WIFI_MAC_DATA_NULL_CFACK_CFPOLL:
+    case WIFI_MAC_QOSDATA_NULL:
+    case WIFI_MAC_QOSDATA_NULL_CFPOLL:
+    case WIFI_MAC_QOSDATA_NULL_CFACK_CFPOLL:
+      // no payload
+      return FRAME_OTHER;
+    case WIFI_MAC_CTL_ACK:
+      return FRAME_ACK;
+    case WIFI_MAC_CTL_BUSY:
+      return FRAME_BUSYTONE;
+    default:
+      break;
+    }
+  // every data subtype left, QoS data (and A-MSDUs) included
+  if (!hdr.IsData () || size <= m_smallFrameSize)
+    {
+      return FRAME_OTHER;
+    }
+  return secondary ? FRAME_SECONDARY : FRAME_PRIMARY;
+}
+
+void
+YansWifiPhy::SetEventLifetime (Time lifetime)
+{
+  m_interference.SetEventLifetime (lifetime);
+}
+
+Time
+YansWifiPhy::GetEventLifetime (void) const
+{
+  return m_interference.GetEventLifetime ();
+}
+
+void
+YansWifiPhy::SetChunkSuccessRateResolution (double resolutionDb)
+{
+  m_interference.SetChunkSuccessRateResolution (resolutionDb);
+}
+
+double
+YansWifiPhy::GetChunkSuccessRateResolution (void) const
+{
+  return m_interference.GetChunkSuccessRateResolution ();
+}
+
+void
+YansWifiPhy::UpdateLiveEvents (void)
+{
+  m_liveEvents = m_interference.GetNEvents ();
+  m_maxLiveEvents = m_interference.GetMaxNEvents ();
+}
+
 void
 YansWifiPhy::Configure80211n (void)
 {
@@ -28,6 +28,7 @@
 #include "ns3/packet.h"
 #include "ns3/object.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
 #include "ns3/nstime.h"
 #include "ns3/ptr.h"
 #include "ns3/random-variable-stream.h"
@@ -68,11 +69,37 @@ class YansWifiPhy : public WifiPhy
 public:
   static TypeId GetTypeId (void);
 
+  /**
+   * The classes of frames counted by the frame statistics.
+   */
+  enum FrameClass
+  {
+    FRAME_PRIMARY = 0,  //!< data frame of a primary transmission
+    FRAME_SECONDARY,    //!< data frame of a secondary transmission
+    FRAME_BUSYTONE,     //!< busytone
+    FRAME_ACK,          //!< ACK
+    FRAME_OTHER,        //!< any other frame, and the small data frames
+    FRAME_CLASSES       //!< number of classes
+  };
+
+  /**
+   * What a receiver needs to know about a frame besides its bytes. The
+   * channel delivers the same read-only packet to every receiver, with
+   * its own copy of this record; the full-duplex fields are filled in
+   * by the sender once per transmission.
+   */
+  struct RxMetadata
+  {
+    RxMetadata ();
+    double rxPowerDbm;     //!< receive power (dBm), before the receiver gain
+    FdTxMetadata tx;       //!< full-duplex information from the sender
+  };
+
   // original
   virtual Time GetPrimaryTransmissionEndTime();
-  void NotifyChangeEndReceive (Ptr<Packet> packet, double rxPowerDbm, enum WifiPreamble preamble, Time rxEndTime);
-  void EndReceiveHeader (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> event, WifiTxVector txVector);
-  void SendBusytone(Ptr<const Packet> packet, WifiTxVector txVector);
+  void NotifyChangeEndReceive (Ptr<const Packet> packet, RxMetadata metadata, enum WifiPreamble preamble, Time rxEndTime);
+  void EndReceiveHeader (Ptr<const Packet> packet, RxMetadata metadata, Ptr<InterferenceHelper::Event> event, WifiTxVector txVector);
+  void SendBusytone(Ptr<const Packet> packet, Time duration);
     
   YansWifiPhy ();
   virtual ~YansWifiPhy ();
@@ -112,15 +139,36 @@ public:
   /**
    * Starting receiving the packet (i.e. the first bit of the preamble has arrived).
    *
-   * \param packet the arriving packet
-   * \param rxPowerDbm the receive power in dBm
+   * \param packet the arriving packet, shared with the other receivers
+   * \param metadata the receive power and full-duplex fields of the packet
    * \param txVector the TXVECTOR of the arriving packet
    * \param preamble the preamble of the arriving packet
    */
-  void StartReceivePacket (Ptr<Packet> packet,
-                           double rxPowerDbm,
+  void StartReceivePacket (Ptr<const Packet> packet,
+                           RxMetadata metadata,
                            WifiTxVector txVector,
                            WifiPreamble preamble);
+  /**
+   * \return the number of received packets this PHY had to copy
+   *         before handing them up
+   */
+  uint64_t GetNPacketCopies (void) const;
+  /**
+   * \param frameClass the class of frames
+   * \return the number of frames of this class this PHY began to
+   *         transmit since the last reset; 0 unless FrameStats is set
+   */
+  uint64_t GetNTxFrames (enum FrameClass frameClass) const;
+  /**
+   * \param frameClass the class of frames
+   * \return the number of frames of this class this PHY received
+   *         successfully since the last reset; 0 unless FrameStats is set
+   */
+  uint64_t GetNRxFrames (enum FrameClass frameClass) const;
+  /**
+   * Clears the frame statistics.
+   */
+  void ResetFrameStats (void);
 
   /**
    * Sets the RX loss (dB) in the Signal-to-Noise-Ratio due to non-idealities in the receiver.
@@ -256,6 +304,8 @@ public:
   virtual void SetReceiveOkCallback (WifiPhy::RxOkCallback callback);
   virtual void SetReceiveErrorCallback (WifiPhy::RxErrorCallback callback);
   virtual void SendPacket (Ptr<const Packet> packet, WifiMode mode, enum WifiPreamble preamble, WifiTxVector txvector);
+  virtual void SendPacket (Ptr<const Packet> packet, WifiMode mode, enum WifiPreamble preamble, WifiTxVector txvector,
+                           const FdTxMetadata &metadata);
   virtual void RegisterListener (WifiPhyListener *listener);
   virtual bool IsStateCcaBusy (void);
   virtual bool IsStateIdle (void);
@@ -369,6 +419,26 @@ public:
    * \param channelbonding Enable or disable channel bonding
    */
   virtual void SetChannelBonding (bool channelbonding) ;
+  /**
+   * Set how long the interference helper keeps the last event of a
+   * silent transmitter.
+   *
+   * \param lifetime the event lifetime
+   */
+  void SetEventLifetime (Time lifetime);
+  /**
+   * \return the event lifetime of the interference helper
+   */
+  Time GetEventLifetime (void) const;
+  /**
+   * \param resolutionDb the SNIR resolution (dB) of the chunk success
+   *        rate cache of the interference helper, 0 to disable it
+   */
+  void SetChunkSuccessRateResolution (double resolutionDb);
+  /**
+   * \return the SNIR resolution (dB) of the chunk success rate cache
+   */
+  double GetChunkSuccessRateResolution (void) const;
 
   virtual uint32_t GetNBssMembershipSelectors (void) const;
   virtual uint32_t GetBssMembershipSelector (uint32_t selector) const;
@@ -462,9 +532,14 @@ private:
    * The last bit of the packet has arrived.
    *
    * \param packet the packet that the last bit has arrived
+   * \param metadata the receive power and full-duplex fields of the packet
    * \param event the corresponding event of the first time the packet arrives
    */
-  void EndReceive (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> event);
+  void EndReceive (Ptr<const Packet> packet, RxMetadata metadata, Ptr<InterferenceHelper::Event> event);
+  /**
+   * Refresh the traced event counters from the interference helper.
+   */
+  void UpdateLiveEvents (void);
 
 private:
   double   m_edThresholdW;        //!< Energy detection threshold in watts
@@ -494,9 +569,30 @@ private:
   WifiTxVector m_sendingTxVector;
   WifiPreamble m_sendingPreamble;
   double       m_sendingPowerDbm;
+  FdTxMetadata m_sendingMetadata;
   bool m_headerErrorFlg;
   Time m_primaryTransmissionEndTime;
   Ptr<InterferenceHelper::Event> m_event;
+  TracedValue<uint32_t> m_liveEvents;    //!< Number of events indexed by the interference helper
+  TracedValue<uint32_t> m_maxLiveEvents; //!< High-water mark of m_liveEvents
+  uint64_t m_nPacketCopies;              //!< Received packets copied before handing them up
+  /**
+   * \param hdr the MAC header of the frame
+   * \param size the size of the frame
+   * \param secondary whether the frame is a secondary transmission
+   * \return the class of the frame for the frame statistics
+   */
+  enum FrameClass ClassifyFrame (const WifiMacHeader &hdr, uint32_t size, bool secondary) const;
+  bool m_frameStats;                     //!< Whether the frames are counted
+  uint32_t m_smallFrameSize;             //!< Data frames up to this size count as FRAME_OTHER
+  uint64_t m_txFrames[FRAME_CLASSES];    //!< Transmitted frames per class
+  uint64_t m_rxFrames[FRAME_CLASSES];    //!< Successfully received frames per class
+
+  /**
+   * The trace source fired when a packet begins the transmission process
+   * on the medium, with the full-duplex metadata sent along with it.
+   */
+  TracedCallback<Ptr<const Packet>, const FdTxMetadata &> m_fdTxBeginTrace;
 
   /**
    * This vector holds the set of transmission modes that this
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014 Yusuke Sugiyama
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., Saruwatari Lab, Shizuoka University, Japan
+ *
+ * Author: Yusuke Sugiyama <sugiyama@aurum.cs.inf.shizuoka.ac.jp>
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/packet.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/yans-wifi-channel.h>
+#include <ns3/yans-wifi-phy.h>
+#include <ns3/wifi-net-device.h>
+#include <ns3/wifi-mac-header.h>
+#include <ns3/fd-tx-metadata.h>
+#include <ns3/basic-energy-source.h>
+#include <ns3/wifi-radio-energy-model.h>
+#include <ns3/wifi-radio-energy-model-helper.h>
+
+
+NS_LOG_COMPONENT_DEFINE ("TestWifiRadioEnergyModel");
+
+using namespace ns3;
+
+/**
+ * The model is installed by WifiRadioEnergyModelHelper, which only
+ * registers its listener on the PHY: the energy of a padded transmission
+ * must still be integrated from the state helper of the PHY.
+ */
+class WifiRadioEnergyModelInstallTestCase : public TestCase
+{
+public:
+  WifiRadioEnergyModelInstallTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Send (void);
+  void CheckState (WifiPhy::State expected);
+
+  Ptr<YansWifiPhy> m_phy;
+  Ptr<WifiRadioEnergyModel> m_model;
+  Time m_txDuration;
+  Time m_padding;
+};
+
+WifiRadioEnergyModelInstallTestCase::WifiRadioEnergyModelInstallTestCase ()
+  : TestCase ("energy of a padded transmission with the helper install")
+{
+}
+
+void
+WifiRadioEnergyModelInstallTestCase::Send (void)
+{
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_DATA);
+  Ptr<Packet> packet = Create<Packet> (1000);
+  packet->AddHeader (hdr);
+  WifiTxVector txVector;
+  txVector.SetMode (WifiPhy::GetOfdmRate6Mbps ());
+  txVector.SetTxPowerLevel (0);
+  txVector.SetNss (1);
+  FdTxMetadata metadata;
+  metadata.busytoneDuration = m_padding;
+  m_txDuration = m_phy->CalculateTxDuration (packet->GetSize (), txVector, WIFI_PREAMBLE_LONG) + m_padding;
+  m_phy->SendPacket (packet, txVector.GetMode (), WIFI_PREAMBLE_LONG, txVector, metadata);
+  Simulator::Schedule (NanoSeconds (m_txDuration.GetNanoSeconds () / 2),
+                       &WifiRadioEnergyModelInstallTestCase::CheckState, this, WifiPhy::TX);
+}
+
+void
+WifiRadioEnergyModelInstallTestCase::CheckState (WifiPhy::State expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_model->GetCurrentState (), expected,
+                         "wrong state at " << Simulator::Now ().GetSeconds () << "s");
+}
+
+void
+WifiRadioEnergyModelInstallTestCase::DoRun (void)
+{
+  m_padding = MicroSeconds (100);
+
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  m_phy = CreateObject<YansWifiPhy> ();
+  m_phy->SetMobility (CreateObject<ConstantPositionMobilityModel> ());
+  m_phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  m_phy->SetChannel (channel);
+  Ptr<WifiNetDevice> device = CreateObject<WifiNetDevice> ();
+  device->SetPhy (m_phy);
+
+  Ptr<BasicEnergySource> source = CreateObject<BasicEnergySource> ();
+  WifiRadioEnergyModelHelper radioEnergyHelper;
+  DeviceEnergyModelContainer models = radioEnergyHelper.Install (device, source);
+  m_model = DynamicCast<WifiRadioEnergyModel> (models.Get (0));
+  NS_TEST_ASSERT_MSG_NE (m_model, 0, "no WifiRadioEnergyModel installed");
+
+  Simulator::Schedule (Seconds (1.0), &WifiRadioEnergyModelInstallTestCase::Send, this);
+  Simulator::Schedule (Seconds (1.5), &WifiRadioEnergyModelInstallTestCase::CheckState, this, WifiPhy::IDLE);
+  Simulator::Stop (Seconds (2.0));
+  Simulator::Run ();
+
+  // the last update is at the end of the transmission
+  double voltage = source->GetSupplyVoltage ();
+  double expected = voltage * (m_model->GetIdleCurrentA () * 1.0
+                               + m_model->GetTxCurrentA () * m_txDuration.GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_model->GetTotalEnergyConsumption (), expected, 1e-12,
+                             "wrong total energy consumption");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_model->GetBusytoneEnergyConsumption (),
+                             voltage * m_model->GetTxCurrentA () * m_padding.GetSeconds (), 1e-12,
+                             "wrong busytone energy consumption");
+
+  Simulator::Destroy ();
+  m_phy = 0;
+  m_model = 0;
+}
+
+class WifiRadioEnergyModelTestSuite : public TestSuite
+{
+public:
+  WifiRadioEnergyModelTestSuite ();
+};
+
+WifiRadioEnergyModelTestSuite::WifiRadioEnergyModelTestSuite ()
+  : TestSuite ("wifi-radio-energy-model", UNIT)
+{
+  AddTestCase (new WifiRadioEnergyModelInstallTestCase, TestCase::QUICK);
+}
+
+static WifiRadioEnergyModelTestSuite staticWifiRadioEnergyModelTestSuiteInstance;
@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014 Yusuke Sugiyama
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., Saruwatari Lab, Shizuoka University, Japan
+ *
+ * Author: Yusuke Sugiyama <sugiyama@aurum.cs.inf.shizuoka.ac.jp>
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/double.h>
+#include <ns3/boolean.h>
+#include <ns3/packet.h>
+#include <ns3/constant-velocity-mobility-model.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/yans-wifi-channel.h>
+#include <ns3/yans-wifi-phy.h>
+#include <ns3/fd-tx-metadata.h>
+#include <vector>
+#include <set>
+
+
+NS_LOG_COMPONENT_DEFINE ("TestYansWifiChannel");
+
+using namespace ns3;
+
+/**
+ * Delay model which records the (sender, receiver) pairs it is asked
+ * about, i.e. the receptions scheduled by YansWifiChannel::Send. The
+ * receivers have no MAC: the receptions are pushed past the end of the
+ * test so that only the scheduling is checked.
+ */
+class RecordingPropagationDelayModel : public PropagationDelayModel
+{
+public:
+  typedef std::set<std::pair<const MobilityModel *, const MobilityModel *> > Links;
+
+  virtual Time GetDelay (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    m_links.insert (std::make_pair (PeekPointer (a), PeekPointer (b)));
+    return Seconds (1000.0);
+  }
+  Links TakeLinks (void)
+  {
+    Links links;
+    links.swap (m_links);
+    return links;
+  }
+
+private:
+  virtual int64_t DoAssignStreams (int64_t stream)
+  {
+    return 0;
+  }
+
+  mutable Links m_links;
+};
+
+/**
+ * Nodes moving with a ConstantVelocityMobilityModel never fire
+ * CourseChange after their velocity is set, so the spatial index must
+ * follow them on its own, while the nodes at rest are only looked at
+ * after a CourseChange: each transmission must reach the same receivers
+ * with and without the index.
+ */
+class SpatialIndexMobilityTestCase : public TestCase
+{
+public:
+  SpatialIndexMobilityTestCase ();
+
+private:
+  virtual void DoRun (void);
+  Ptr<YansWifiChannel> CreateChannel (Ptr<RecordingPropagationDelayModel> delay, bool spatialIndex);
+  void SendAll (void);
+
+  std::vector<Ptr<YansWifiPhy> > m_gridPhys;
+  std::vector<Ptr<YansWifiPhy> > m_bruteForcePhys;
+  std::vector<Ptr<ConstantVelocityMobilityModel> > m_mobilities;
+  Ptr<YansWifiChannel> m_grid;
+  Ptr<YansWifiChannel> m_bruteForce;
+  Ptr<RecordingPropagationDelayModel> m_gridLinks;
+  Ptr<RecordingPropagationDelayModel> m_bruteForceLinks;
+  uint32_t m_nSends;
+};
+
+SpatialIndexMobilityTestCase::SpatialIndexMobilityTestCase ()
+  : TestCase ("spatial index vs brute force with moving nodes"),
+    m_nSends (0)
+{
+}
+
+Ptr<YansWifiChannel>
+SpatialIndexMobilityTestCase::CreateChannel (Ptr<RecordingPropagationDelayModel> delay, bool spatialIndex)
+{
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetAttribute ("SpatialIndex", BooleanValue (spatialIndex));
+  channel->SetAttribute ("MaxRange", DoubleValue (100.0));
+  channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  channel->SetPropagationDelayModel (delay);
+  return channel;
+}
+
+void
+SpatialIndexMobilityTestCase::SendAll (void)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  for (uint32_t i = 0; i < m_gridPhys.size (); i++)
+    {
+      m_grid->Send (m_gridPhys[i], packet, FdTxMetadata (), 16.0, WifiTxVector (), WIFI_PREAMBLE_LONG);
+      m_bruteForce->Send (m_bruteForcePhys[i], packet, FdTxMetadata (), 16.0, WifiTxVector (), WIFI_PREAMBLE_LONG);
+      RecordingPropagationDelayModel::Links gridLinks = m_gridLinks->TakeLinks ();
+      RecordingPropagationDelayModel::Links bruteForceLinks = m_bruteForceLinks->TakeLinks ();
+      NS_TEST_EXPECT_MSG_EQ (gridLinks.size (), bruteForceLinks.size (),
+                             "sender " << i << " at " << Simulator::Now ().GetSeconds () << "s");
+      NS_TEST_EXPECT_MSG_EQ ((gridLinks == bruteForceLinks), true,
+                             "receivers of sender " << i << " at " << Simulator::Now ().GetSeconds () << "s");
+    }
+  m_nSends++;
+}
+
+void
+SpatialIndexMobilityTestCase::DoRun (void)
+{
+  m_gridLinks = CreateObject<RecordingPropagationDelayModel> ();
+  m_bruteForceLinks = CreateObject<RecordingPropagationDelayModel> ();
+  m_grid = CreateChannel (m_gridLinks, true);
+  m_bruteForce = CreateChannel (m_bruteForceLinks, false);
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Ptr<ConstantVelocityMobilityModel> mobility = CreateObject<ConstantVelocityMobilityModel> ();
+      mobility->SetPosition (Vector (30.0 * i, 40.0 * (i % 3), 0.0));
+      // every fourth node is at rest
+      if (i % 4 != 0)
+        {
+          mobility->SetVelocity (Vector ((i % 2) ? 25.0 : -25.0, (i % 3) ? 10.0 : -10.0, 0.0));
+        }
+      m_mobilities.push_back (mobility);
+      Ptr<YansWifiPhy> gridPhy = CreateObject<YansWifiPhy> ();
+      gridPhy->SetMobility (mobility);
+      gridPhy->SetChannel (m_grid);
+      m_gridPhys.push_back (gridPhy);
+      Ptr<YansWifiPhy> bruteForcePhy = CreateObject<YansWifiPhy> ();
+      bruteForcePhy->SetMobility (mobility);
+      bruteForcePhy->SetChannel (m_bruteForce);
+      m_bruteForcePhys.push_back (bruteForcePhy);
+    }
+  for (uint32_t t = 0; t <= 20; t++)
+    {
+      Simulator::Schedule (Seconds (t), &SpatialIndexMobilityTestCase::SendAll, this);
+    }
+  // a node at rest jumps away, a moving node stops and starts again
+  Simulator::Schedule (Seconds (5.5), &ConstantVelocityMobilityModel::SetPosition,
+                       m_mobilities[4], Vector (400.0, 80.0, 0.0));
+  Simulator::Schedule (Seconds (7.5), &ConstantVelocityMobilityModel::SetVelocity,
+                       m_mobilities[5], Vector (0.0, 0.0, 0.0));
+  Simulator::Schedule (Seconds (12.5), &ConstantVelocityMobilityModel::SetVelocity,
+                       m_mobilities[5], Vector (0.0, 30.0, 0.0));
+  Simulator::Stop (Seconds (21));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_EQ (m_nSends, 21u, "every round of transmissions ran");
+  m_gridPhys.clear ();
+  m_bruteForcePhys.clear ();
+  m_mobilities.clear ();
+  m_grid = 0;
+  m_bruteForce = 0;
+  m_gridLinks = 0;
+  m_bruteForceLinks = 0;
+}
+
+class YansWifiChannelTestSuite : public TestSuite
+{
+public:
+  YansWifiChannelTestSuite ();
+};
+
+YansWifiChannelTestSuite::YansWifiChannelTestSuite ()
+  : TestSuite ("yans-wifi-channel", UNIT)
+{
+  AddTestCase (new SpatialIndexMobilityTestCase, TestCase::QUICK);
+}
+
+static YansWifiChannelTestSuite staticYansWifiChannelTestSuiteInstance;
@@ -20,6 +20,7 @@
 
 #include <ns3/log.h>
 #include <cmath>
+#include <algorithm>
 #include "wifi-antenna-model.h"
 #include "ns3/orientation-model.h"
 #include "ns3/antenna-model.h"
@@ -35,6 +36,11 @@ WifiAntennaListener::~WifiAntennaListener ()
 {
 }
 
+void
+WifiAntennaListener::NotifyChangeGainPattern (void)
+{
+}
+
 TypeId 
 WifiAntennaModel::GetTypeId (void)
 {
@@ -55,6 +61,7 @@ WifiAntennaModel::~WifiAntennaModel ()
 void
 WifiAntennaModel::SetOrientationModel (Ptr<OrientationModel> orientation){
   m_orientation = orientation;
+  DoOrientationChanged ();
 }
 
 Angles
@@ -65,6 +72,7 @@ WifiAntennaModel::GetOrientation (){
 void
 WifiAntennaModel::SetOrientation (const Angles &orientation){
   m_orientation->SetOrientation(orientation);
+  DoOrientationChanged ();
 }
 
 double
@@ -87,6 +95,39 @@ WifiAntennaModel::GetGainDb (Ptr<MobilityModel> src, Ptr<MobilityModel> dest){
   return DoGetGainDb (oriSum);
 }
 
+double
+WifiAntennaModel::GetGainDb (Ptr<const MobilityModel> src, Ptr<const MobilityModel> dest, int mode) const
+{
+  Angles ori = DoGetModeOrientation (mode);
+  Angles bet (dest->GetPosition (), src->GetPosition ());
+  Angles a;
+  a.phi = NormalizeOverTwoPI (bet.phi - ori.phi);
+  a.theta = NormalizeOverTwoPI (bet.theta - ori.theta);
+  return DoGetGainDb (a, mode);
+}
+
+double
+WifiAntennaModel::DoGetGainDb (Angles a, int mode) const
+{
+  return DoGetGainDb (a);
+}
+
+Angles
+WifiAntennaModel::DoGetModeOrientation (int mode) const
+{
+  if (m_orientation != 0)
+    {
+      return m_orientation->GetOrientation ();
+    }
+  return Angles ();
+}
+
+void
+WifiAntennaModel::DoOrientationChanged (void)
+{
+  NotifyChangeGainPattern ();
+}
+
 void
 WifiAntennaModel::SetAntennaMode (int mode){
   m_antennaMode = mode;
@@ -108,6 +149,12 @@ WifiAntennaModel::GetAntennaMode (){
   return m_antennaMode;
 }
 
+int
+WifiAntennaModel::GetNAntennaModes (void) const
+{
+  return NUMBER_OF_ANTENNA_MODES;
+}
+
 void
 WifiAntennaModel::RegisterListener (WifiAntennaListener *listener)
 {
@@ -115,6 +162,17 @@ WifiAntennaModel::RegisterListener (WifiAntennaListener *listener)
   m_listeners.push_back (listener);
 }
 
+void
+WifiAntennaModel::UnregisterListener (WifiAntennaListener *listener)
+{
+  NS_LOG_FUNCTION (this << listener);
+  Listeners::iterator i = std::find (m_listeners.begin (), m_listeners.end (), listener);
+  if (i != m_listeners.end ())
+    {
+      m_listeners.erase (i);
+    }
+}
+
 void
 WifiAntennaModel::NotifyChangeAntennaMode (int mode)
 {
@@ -125,4 +183,13 @@ WifiAntennaModel::NotifyChangeAntennaMode (int mode)
     }
 }
 
+void
+WifiAntennaModel::NotifyChangeGainPattern (void)
+{
+  for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
+    {
+      (*i)->NotifyChangeGainPattern ();
+    }
+}
+
 }
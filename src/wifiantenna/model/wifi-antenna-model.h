@@ -36,6 +36,12 @@ class WifiAntennaListener
 public:
   virtual ~WifiAntennaListener ();
   virtual void NotifyChangeAntennaMode (int mode) = 0;
+  /**
+   * Called when the gain of some antenna mode may have changed, e.g.
+   * the orientation or a beamwidth was set. The default implementation
+   * does nothing.
+   */
+  virtual void NotifyChangeGainPattern (void);
 };
 
 /** 
@@ -75,17 +81,40 @@ public:
    * \return gain in db
    */
   virtual double GetGainDb (Ptr<MobilityModel> src, Ptr<MobilityModel> dest);
+  /**
+   * Side-effect free variant of GetGainDb: the gain is evaluated as if
+   * the antenna were in the given mode, without switching it.
+   *
+   * \param src mobility of the node the antenna is on
+   * \param dest mobility of the other node
+   * \param mode the antenna mode to evaluate
+   * \return gain in db
+   */
+  double GetGainDb (Ptr<const MobilityModel> src, Ptr<const MobilityModel> dest, int mode) const;
   virtual void SetAntennaMode (int mode);
   virtual void SetAntennaMode (Angles bet);
   virtual int GetNextAntennaMode (Angles bet);
   int GetAntennaMode ();
+  /**
+   * \return the number of antenna modes, including OMNI (mode 0)
+   */
+  virtual int GetNAntennaModes (void) const;
 
   void SetOrientationModel (Ptr<OrientationModel> orientation);
   Angles GetOrientation ();
   void SetOrientation (const Angles &orientation);
 
   void RegisterListener (WifiAntennaListener *listener);
+  /**
+   * \param listener a listener passed to RegisterListener before; it is
+   *        not notified anymore and may be deleted by its owner.
+   */
+  void UnregisterListener (WifiAntennaListener *listener);
   void NotifyChangeAntennaMode (int mode);
+  /**
+   * Tell the listeners that the gain of some antenna mode may have changed.
+   */
+  void NotifyChangeGainPattern (void);
 
 protected:
   typedef std::vector<WifiAntennaListener *> Listeners;
@@ -102,7 +131,29 @@ private:
    * isotropic radiator. Since a power gain is used, the efficiency of
    * the antenna is expected to be included in the gain value. 
    */
-  virtual double DoGetGainDb (Angles a) = 0;
+  virtual double DoGetGainDb (Angles a) const = 0;
+  /**
+   * \param a the spherical angles w.r.t. the orientation of the mode
+   * \param mode the antenna mode to evaluate
+   * \return the power gain in dBi of the radiation pattern of the mode.
+   *
+   * Models without modes evaluate their single pattern.
+   */
+  virtual double DoGetGainDb (Angles a, int mode) const;
+  /**
+   * \param mode the antenna mode
+   * \return the orientation the antenna has in this mode.
+   *
+   * Models without modes return the current orientation.
+   */
+  virtual Angles DoGetModeOrientation (int mode) const;
+  /**
+   * Called when the orientation or the orientation model is set, so
+   * that models caching the applied orientation can drop it. The default
+   * implementation calls NotifyChangeGainPattern: the mode orientation
+   * is the current orientation.
+   */
+  virtual void DoOrientationChanged (void);
 
   Ptr<OrientationModel> m_orientation;
 };
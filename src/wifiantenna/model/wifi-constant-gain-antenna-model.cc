@@ -72,7 +72,7 @@ WifiConstantGainAntennaModel::GetTypeId ()
 }
 
 double
-WifiConstantGainAntennaModel::DoGetGainDb (Angles a)
+WifiConstantGainAntennaModel::DoGetGainDb (Angles a) const
 {
   NS_LOG_FUNCTION (this << a);
   if((GetAzimuthBeamwidth()/2) > 0 && (GetAzimuthBeamwidth()/2) < M_PI/2)
@@ -94,6 +94,7 @@ WifiConstantGainAntennaModel::SetGainInsidePattern (double gain)
 {
   NS_LOG_FUNCTION (this << gain);
   m_innerGain = gain;
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -107,6 +108,7 @@ WifiConstantGainAntennaModel::SetGainOutsidePattern (double gain)
 {
   NS_LOG_FUNCTION (this << gain);
   m_outerGain = gain;
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -120,6 +122,7 @@ WifiConstantGainAntennaModel::SetAzimuthBeamwidth (double bw)
 {
   NS_LOG_FUNCTION (this << bw);
   m_aziBW = NormalizeOverTwoPI(bw);
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -133,6 +136,7 @@ WifiConstantGainAntennaModel::SetElevationBeamwidth (double bw)
 {
   NS_LOG_FUNCTION (this << bw);
   m_elvBW = NormalizeOverPI(bw);
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -64,7 +64,7 @@ private:
   double m_elvBW;
  
   //Angles m_orientation;
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
 };
 
 }
@@ -62,6 +62,7 @@ WifiCosineAntennaModel::SetBeamwidth (double beamwidthDegrees)
   m_beamwidthRadians = DegreesToRadians (beamwidthDegrees);
   m_exponent = -3.0 / (20 * std::log10 (std::cos (m_beamwidthRadians / 4.0)));
   NS_LOG_LOGIC (this << " m_exponent = " << m_exponent);
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -71,7 +72,7 @@ WifiCosineAntennaModel::GetBeamwidth () const
 }
 
 double 
-WifiCosineAntennaModel::DoGetGainDb (Angles a)
+WifiCosineAntennaModel::DoGetGainDb (Angles a) const
 {
   NS_LOG_FUNCTION (this << a);
   // azimuth angle w.r.t. the reference system of the antenna
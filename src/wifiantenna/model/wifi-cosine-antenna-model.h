@@ -64,7 +64,7 @@ private:
   double m_maxGain;
   
   // inherited from AntennaModel
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
 };
 
 
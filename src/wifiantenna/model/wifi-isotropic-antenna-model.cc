@@ -49,7 +49,7 @@ WifiIsotropicAntennaModel::WifiIsotropicAntennaModel ()
 }
 
 double 
-WifiIsotropicAntennaModel::DoGetGainDb (Angles a)
+WifiIsotropicAntennaModel::DoGetGainDb (Angles a) const
 {
   NS_LOG_FUNCTION (this << a);
   return 0.0;
@@ -43,7 +43,7 @@ public:
 private:
 
   // inherited from WifiAntennaModel
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
 
 };
 
@@ -61,6 +61,7 @@ WifiParabolicAntennaModel::SetBeamwidth (double beamwidthDegrees)
 { 
   NS_LOG_FUNCTION (this << beamwidthDegrees);
   m_beamwidthRadians = DegreesToRadians (beamwidthDegrees);
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -70,7 +71,7 @@ WifiParabolicAntennaModel::GetBeamwidth () const
 }
 
 double 
-WifiParabolicAntennaModel::DoGetGainDb (Angles a)
+WifiParabolicAntennaModel::DoGetGainDb (Angles a) const
 {
   NS_LOG_FUNCTION (this << a);
   // azimuth angle w.r.t. the reference system of the antenna
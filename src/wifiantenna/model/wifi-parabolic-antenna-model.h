@@ -62,7 +62,7 @@ private:
   double m_maxAttenuation;
 
   // inherited from WifiAntennaModel
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
 };
 
 
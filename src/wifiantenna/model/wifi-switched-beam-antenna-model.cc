@@ -21,7 +21,10 @@
 
 #include <ns3/log.h>
 #include <ns3/double.h>
+#include <ns3/uinteger.h>
+#include <ns3/trace-source-accessor.h>
 #include <limits>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 
@@ -48,21 +51,22 @@ WifiSwitchedBeamAntennaModel::GetTypeId ()
                         &WifiSwitchedBeamAntennaModel::GetGainOmniMode),
                    MakeDoubleChecker<double> ())
     .AddAttribute ("InsideGain",
-                   "The gain inside the radiation pattern (dbm)",
+                   "The gain inside the radiation pattern of every sector (dbm)",
                    DoubleValue (0),
                    MakeDoubleAccessor (
                         &WifiSwitchedBeamAntennaModel::SetGainInsidePattern, 
                         &WifiSwitchedBeamAntennaModel::GetGainInsidePattern),
                    MakeDoubleChecker<double> ())
     .AddAttribute ("OutsideGain",
-                   "The gain outside the radiation pattern (dbm)",
+                   "The gain outside the radiation pattern of every sector (dbm)",
                    DoubleValue (-80),
                    MakeDoubleAccessor (
                         &WifiSwitchedBeamAntennaModel::SetGainOutsidePattern, 
                         &WifiSwitchedBeamAntennaModel::GetGainOutsidePattern),
                    MakeDoubleChecker<double> ())
     .AddAttribute ("AzimuthBeamwidth",
-                   "The estimated Azimuth Beamwidth of the radiation pattern (radians)",
+                   "The estimated Azimuth Beamwidth of the radiation pattern (radians). "
+                   "Set by SetAntennaMode to the beamwidth of the selected mode.",
                    DoubleValue (2*M_PI),
                    MakeDoubleAccessor (
                         &WifiSwitchedBeamAntennaModel::SetAzimuthBeamwidth, 
@@ -75,34 +79,108 @@ WifiSwitchedBeamAntennaModel::GetTypeId ()
                         &WifiSwitchedBeamAntennaModel::SetElevationBeamwidth, 
                         &WifiSwitchedBeamAntennaModel::GetElevationBeamwidth),
                    MakeDoubleChecker<double> (0, M_PI)) 
+    .AddAttribute ("Sectors",
+                   "The number of sectors, i.e. of directional modes. "
+                   "Changing it resets the per-sector gains to InsideGain/OutsideGain "
+                   "and puts an antenna whose sector is removed back to OMNI.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (
+                        &WifiSwitchedBeamAntennaModel::SetNSectors,
+                        &WifiSwitchedBeamAntennaModel::GetNSectors),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("AzimuthBins",
+                   "The number of azimuth bins of the precomputed gain table of each sector",
+                   UintegerValue (720),
+                   MakeUintegerAccessor (
+                        &WifiSwitchedBeamAntennaModel::SetNAzimuthBins,
+                        &WifiSwitchedBeamAntennaModel::GetNAzimuthBins),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("ModeSwitches",
+                     "The number of times the antenna changed its mode.",
+                     MakeTraceSourceAccessor (&WifiSwitchedBeamAntennaModel::m_nModeSwitches))
     ;
   return tid;
 }
 
+WifiSwitchedBeamAntennaModel::WifiSwitchedBeamAntennaModel ()
+  : m_innerGain (0),
+    m_outerGain (-80),
+    m_omniGain (0),
+    m_aziBW (2*M_PI),
+    m_elvBW (M_PI),
+    m_sectors (4),
+    m_azimuthBins (720),
+    m_sectorInnerGain (4, 0),
+    m_sectorOuterGain (4, -80),
+    m_gainTableValid (false),
+    m_modeApplied (false),
+    m_nModeSwitches (0)
+{
+  m_antennaMode = OMNI;
+  BuildModeTable ();
+}
+
+double
+WifiSwitchedBeamAntennaModel::DoGetGainDb (Angles a) const
+{
+  return DoGetGainDb (a, m_antennaMode);
+}
+
 double
-WifiSwitchedBeamAntennaModel::DoGetGainDb (Angles a)
+WifiSwitchedBeamAntennaModel::DoGetGainDb (Angles a, int mode) const
 {
-  //  double phi   = GetOrientation().phi;
-  //  double theta = GetOrientation().theta;
-  NS_LOG_FUNCTION (this << a);
-  if(m_antennaMode == OMNI) {
+  NS_LOG_FUNCTION (this << a << mode);
+  if(mode == OMNI) {
     return m_omniGain;
   }
-  if((GetAzimuthBeamwidth()/2) > 0 && (GetAzimuthBeamwidth()/2) < M_PI/2)
-  {
-    if(a.phi > (GetAzimuthBeamwidth()/2) && a.phi <= M_PI){
-      return m_outerGain;
-    }
-    if(a.phi < ((M_PI*2)-(GetAzimuthBeamwidth()/2)) && a.phi >= M_PI) {
-      return m_outerGain;
+  NS_ASSERT (mode >= 1 && mode <= (int)m_sectors);
+  uint32_t sector = mode - 1;
+  if(a.theta > (m_elvBW/2)){
+    return m_sectorOuterGain[sector];
+  }
+  if(!m_gainTableValid){
+    BuildGainTable ();
+  }
+  uint32_t bin = static_cast<uint32_t> (a.phi * m_azimuthBins / (2*M_PI));
+  if(bin >= m_azimuthBins){
+    // a.phi == 2pi
+    bin = m_azimuthBins - 1;
+  }
+  return m_gainTable[sector * m_azimuthBins + bin];
+}
+
+void
+WifiSwitchedBeamAntennaModel::BuildGainTable (void) const
+{
+  NS_LOG_FUNCTION (this);
+  double halfWidth = M_PI / m_sectors;
+  m_gainTable.resize (m_sectors * m_azimuthBins);
+  for(uint32_t k = 0; k < m_sectors; k++){
+    for(uint32_t b = 0; b < m_azimuthBins; b++){
+      // centre of the bin relative to the centre of the sector, in (-pi, pi]
+      double phi = (b + 0.5) * 2*M_PI / m_azimuthBins;
+      if(phi > M_PI){
+        phi -= 2*M_PI;
+      }
+      m_gainTable[k * m_azimuthBins + b] =
+        (std::fabs (phi) <= halfWidth) ? m_sectorInnerGain[k] : m_sectorOuterGain[k];
     }
   }
+  m_gainTableValid = true;
+}
 
-  if(a.theta > (GetElevationBeamwidth()/2)){
-    return m_outerGain;
+void
+WifiSwitchedBeamAntennaModel::BuildModeTable (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_modeOrientation.assign (m_sectors + 1, Angles (0, 0));
+  m_modeBeamwidth.assign (m_sectors + 1, 0);
+  for(uint32_t k = 0; k < m_sectors; k++){
+    m_modeOrientation[DIRECTIONAL0 + k] = Angles ((k + 0.5) * 2*M_PI / m_sectors, (double)0);
+    m_modeBeamwidth[DIRECTIONAL0 + k] = 2*M_PI / m_sectors;
   }
-   
-  return m_innerGain;
+  // the orientation of the current mode may have changed
+  m_modeApplied = false;
 }
 
 void 
@@ -110,6 +188,9 @@ WifiSwitchedBeamAntennaModel::SetGainInsidePattern (double gain)
 {
   NS_LOG_FUNCTION (this << gain);
   m_innerGain = gain;
+  m_sectorInnerGain.assign (m_sectors, gain);
+  m_gainTableValid = false;
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -123,6 +204,9 @@ WifiSwitchedBeamAntennaModel::SetGainOutsidePattern (double gain)
 {
   NS_LOG_FUNCTION (this << gain);
   m_outerGain = gain;
+  m_sectorOuterGain.assign (m_sectors, gain);
+  m_gainTableValid = false;
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -136,6 +220,7 @@ WifiSwitchedBeamAntennaModel::SetGainOmniMode (double gain)
 {
   NS_LOG_FUNCTION (this << gain);
   m_omniGain = gain;
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -144,11 +229,63 @@ WifiSwitchedBeamAntennaModel::GetGainOmniMode (void) const
   return m_omniGain;
 }
 
+void
+WifiSwitchedBeamAntennaModel::SetSectorGain (uint32_t sector, double insideGain, double outsideGain)
+{
+  NS_LOG_FUNCTION (this << sector << insideGain << outsideGain);
+  NS_ASSERT (sector < m_sectors);
+  m_sectorInnerGain[sector] = insideGain;
+  m_sectorOuterGain[sector] = outsideGain;
+  m_gainTableValid = false;
+  NotifyChangeGainPattern ();
+}
+
+void
+WifiSwitchedBeamAntennaModel::SetNSectors (uint32_t sectors)
+{
+  NS_LOG_FUNCTION (this << sectors);
+  NS_ASSERT (sectors > 0);
+  m_sectors = sectors;
+  m_sectorInnerGain.assign (m_sectors, m_innerGain);
+  m_sectorOuterGain.assign (m_sectors, m_outerGain);
+  m_gainTableValid = false;
+  BuildModeTable ();
+  if(m_antennaMode > (int)m_sectors){
+    // the sector of the current mode does not exist anymore
+    NS_LOG_DEBUG ("mode " << m_antennaMode << " removed, back to OMNI");
+    m_antennaMode = OMNI;
+  }
+  NotifyChangeGainPattern ();
+}
+
+uint32_t
+WifiSwitchedBeamAntennaModel::GetNSectors (void) const
+{
+  return m_sectors;
+}
+
+void
+WifiSwitchedBeamAntennaModel::SetNAzimuthBins (uint32_t bins)
+{
+  NS_LOG_FUNCTION (this << bins);
+  NS_ASSERT (bins > 0);
+  m_azimuthBins = bins;
+  m_gainTableValid = false;
+  NotifyChangeGainPattern ();
+}
+
+uint32_t
+WifiSwitchedBeamAntennaModel::GetNAzimuthBins (void) const
+{
+  return m_azimuthBins;
+}
+
 void
 WifiSwitchedBeamAntennaModel::SetAzimuthBeamwidth (double bw)
 {
   NS_LOG_FUNCTION (this << bw);
   m_aziBW = NormalizeOverTwoPI(bw);
+  m_modeApplied = false;
 }
 
 
@@ -163,6 +300,7 @@ WifiSwitchedBeamAntennaModel::SetElevationBeamwidth (double bw)
 {
   NS_LOG_FUNCTION (this << bw);
   m_elvBW = NormalizeOverPI(bw);
+  NotifyChangeGainPattern ();
 }
 
 double
@@ -171,81 +309,75 @@ WifiSwitchedBeamAntennaModel::GetElevationBeamwidth (void) const
   return m_elvBW;
 }
 
+int
+WifiSwitchedBeamAntennaModel::GetNAntennaModes (void) const
+{
+  return m_sectors + 1;
+}
+
 int
 WifiSwitchedBeamAntennaModel::GetNextAntennaMode (Angles bet){
+  uint32_t sector = static_cast<uint32_t> (NormalizeOverTwoPI (bet.phi) / (2*M_PI / m_sectors));
+  if(sector >= m_sectors){
+    // bet.phi == 2pi
+    sector = m_sectors - 1;
+  }
+  return DIRECTIONAL0 + sector;
+}
+
+double
+WifiSwitchedBeamAntennaModel::GetModeAzimuthBeamwidth (int mode) const
+{
+  if(mode < OMNI || mode > (int)m_sectors){
+    return 0;
+  }
+  return m_modeBeamwidth[mode];
+}
 
-  double ang0   = 0;
-  double ang90  = M_PI / 2;
-  double ang180 = M_PI;
-  double ang270 = 3 * M_PI / 2;
-
-  if(bet.phi >= ang0 && bet.phi < ang90){
-    return DIRECTIONAL0;
-  }else if(bet.phi >= ang90 && bet.phi < ang180){
-    return DIRECTIONAL90;
-  }else if(bet.phi >= ang180 && bet.phi < ang270){
-    return DIRECTIONAL180;
-  }else{
-    return DIRECTIONAL270;
+Angles
+WifiSwitchedBeamAntennaModel::DoGetModeOrientation (int mode) const
+{
+  if(mode < OMNI || mode > (int)m_sectors){
+    return Angles (0, 0);
   }
+  return m_modeOrientation[mode];
 }
 
 void
 WifiSwitchedBeamAntennaModel::SetAntennaMode (int mode)
 {
+  if(m_modeApplied && mode == m_antennaMode){
+    return;
+  }
+  NS_LOG_FUNCTION (this << mode);
   m_antennaMode = mode;
 
-  Angles ang0(0, 0);
-  Angles ang45((double)M_PI / 4, (double)0);
-  Angles ang135((double)3 * M_PI / 4, (double)0);
-  Angles ang225((double)5 * M_PI / 4, (double)0);
-  Angles ang315((double)7 * M_PI / 4, (double)0);
-
-  switch(mode){
-  case OMNI:
-    SetAzimuthBeamwidth (0);
-    SetOrientation (ang0);
-    break;
-  case DIRECTIONAL0:
-    SetAzimuthBeamwidth (M_PI / 2);
-    SetOrientation (ang45);
-    break;
-  case DIRECTIONAL90:
-    SetAzimuthBeamwidth (M_PI / 2);
-    SetOrientation (ang135);
-    break;
-  case DIRECTIONAL180:
-    SetAzimuthBeamwidth (M_PI / 2);
-    SetOrientation (ang225);
-    break;
-  case DIRECTIONAL270:
-    SetAzimuthBeamwidth (M_PI / 2);
-    SetOrientation (ang315);
-    break;
-  }
+  SetAzimuthBeamwidth (GetModeAzimuthBeamwidth (mode));
+  SetOrientation (DoGetModeOrientation (mode));
+  // set last, the two setters above clear it
+  m_modeApplied = true;
+  m_nModeSwitches++;
 
-  for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
-    {
-      (*i)->NotifyChangeAntennaMode (mode);
-    }
+  NotifyChangeAntennaMode (mode);
 }
 void
 WifiSwitchedBeamAntennaModel::SetAntennaMode (Angles bet)
 {
-  double ang0   = 0;
-  double ang90  = M_PI / 2;
-  double ang180 = M_PI;
-  double ang270 = 3 * M_PI / 2;
-
-  if(bet.phi >= ang0 && bet.phi < ang90){
-    SetAntennaMode (DIRECTIONAL0);
-  }else if(bet.phi >= ang90 && bet.phi < ang180){
-    SetAntennaMode (DIRECTIONAL90);
-  }else if(bet.phi >= ang180 && bet.phi < ang270){
-    SetAntennaMode (DIRECTIONAL180);
-  }else{
-    SetAntennaMode (DIRECTIONAL270);
-  }
+  SetAntennaMode (GetNextAntennaMode (bet));
+}
+
+void
+WifiSwitchedBeamAntennaModel::DoOrientationChanged (void)
+{
+  // The sector patterns are fixed to the node, the mode gains do not
+  // follow the orientation: the listeners are not notified.
+  m_modeApplied = false;
+}
+
+uint32_t
+WifiSwitchedBeamAntennaModel::GetNModeSwitches (void) const
+{
+  return m_nModeSwitches;
 }
 
 }
@@ -22,12 +22,29 @@
 #ifndef WIFI_SWITCHED_BEAM_ANTENNA_MODEL_H
 #define WIFI_SWITCHED_BEAM_ANTENNA_MODEL_H
 
+#include <vector>
 #include <ns3/object.h>
+#include <ns3/traced-value.h>
 #include <ns3/wifi-antenna-model.h>
 
 namespace ns3 {
 
 
+/**
+ * \brief switched-beam antenna with N equal sectors
+ *
+ * Mode 0 is omni-directional; mode k (1 <= k <= N) points the main lobe
+ * of the k-th sector, centred at (k - 1/2) * 2pi/N with a beamwidth of
+ * 2pi/N. Each sector has its own main-lobe and side-lobe gain. The gain
+ * of every mode is precomputed into a table of azimuth bins, so a gain
+ * query is a single lookup. Sector boundaries are resolved to the bin
+ * width; with AzimuthBins a multiple of 2N they fall on bin edges.
+ *
+ * The default of 4 sectors gives the DIRECTIONAL0..DIRECTIONAL270 modes.
+ * The orientation and beamwidth of every mode are tabulated when the
+ * number of sectors is set, and switching to the current mode again
+ * does nothing.
+ */
 class WifiSwitchedBeamAntennaModel : public WifiAntennaModel
 {
 public:
@@ -41,7 +58,9 @@ public:
   // inherited from Object
   static TypeId GetTypeId ();
 
-  // sets the antenna gain in Db
+  WifiSwitchedBeamAntennaModel ();
+
+  // sets the antenna gain in Db of every sector
   void SetGainInsidePattern (double gain);
   double GetGainInsidePattern (void) const;
 
@@ -51,6 +70,15 @@ public:
   void SetGainOmniMode (double gain);
   double GetGainOmniMode (void) const;
 
+  // sets the main-lobe and side-lobe gain in Db of one sector (0-based)
+  void SetSectorGain (uint32_t sector, double insideGain, double outsideGain);
+
+  void SetNSectors (uint32_t sectors);
+  uint32_t GetNSectors (void) const;
+
+  void SetNAzimuthBins (uint32_t bins);
+  uint32_t GetNAzimuthBins (void) const;
+
   // in radians
   void SetAzimuthBeamwidth (double bw);
   double GetAzimuthBeamwidth (void) const;
@@ -62,6 +90,11 @@ public:
   int GetNextAntennaMode (Angles bet);
   void SetAntennaMode (int mode);
   void SetAntennaMode (Angles bet);
+  virtual int GetNAntennaModes (void) const;
+  /**
+   * \return the number of times the antenna actually changed its mode
+   */
+  uint32_t GetNModeSwitches (void) const;
 
 private:
   double m_innerGain;
@@ -69,9 +102,32 @@ private:
   double m_omniGain;
   double m_aziBW;
   double m_elvBW;
+  uint32_t m_sectors;
+  uint32_t m_azimuthBins;
+  std::vector<double> m_sectorInnerGain;
+  std::vector<double> m_sectorOuterGain;
+
+  // gain per (mode - 1, azimuth bin), rebuilt when the configuration changes
+  mutable std::vector<double> m_gainTable;
+  mutable bool m_gainTableValid;
+
+  // orientation and azimuth beamwidth per mode, OMNI included
+  std::vector<Angles> m_modeOrientation;
+  std::vector<double> m_modeBeamwidth;
+  // false until a mode has been applied to the orientation model, and
+  // again once the orientation or the beamwidth is set from outside
+  bool m_modeApplied;
+  TracedValue<uint32_t> m_nModeSwitches;
  
   //Angles m_orientation;
-  virtual double DoGetGainDb (Angles a);
+  virtual double DoGetGainDb (Angles a) const;
+  virtual double DoGetGainDb (Angles a, int mode) const;
+  virtual Angles DoGetModeOrientation (int mode) const;
+  virtual void DoOrientationChanged (void);
+  // azimuth beamwidth (radians) used in the given mode
+  double GetModeAzimuthBeamwidth (int mode) const;
+  void BuildGainTable (void) const;
+  void BuildModeTable (void);
 };
 
 }
@@ -0,0 +1,200 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014 Yusuke Sugiyama
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., Saruwatari Lab, Shizuoka University, Japan
+ *
+ * Author: Yusuke Sugiyama <sugiyama@aurum.cs.inf.shizuoka.ac.jp>
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/double.h>
+#include <ns3/uinteger.h>
+#include <ns3/wifi-switched-beam-antenna-model.h>
+#include <ns3/orientation-module.h>
+#include <ns3/mobility-module.h>
+#include <cmath>
+#include <string>
+#include <sstream>
+
+
+NS_LOG_COMPONENT_DEFINE ("TestWifiSwitchedBeamAntennaModel");
+
+using namespace ns3;
+
+class SwitchedBeamAntennaModelTestCase : public TestCase
+{
+public:
+  static std::string BuildNameString (uint32_t sectors, int mode, double phi);
+  SwitchedBeamAntennaModelTestCase (uint32_t sectors, int mode, double phi, double expectedGainDb);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_sectors;
+  int m_mode;
+  double m_phi;
+  double m_expectedGain;
+};
+
+std::string SwitchedBeamAntennaModelTestCase::BuildNameString (uint32_t sectors, int mode, double phi)
+{
+  std::ostringstream oss;
+  oss << "sectors=" << sectors
+      << ", mode=" << mode
+      << ", phi=" << phi << "deg";
+  return oss.str ();
+}
+
+SwitchedBeamAntennaModelTestCase::SwitchedBeamAntennaModelTestCase (uint32_t sectors, int mode, double phi, double expectedGainDb)
+  : TestCase (BuildNameString (sectors, mode, phi)),
+    m_sectors (sectors),
+    m_mode (mode),
+    m_phi (phi),
+    m_expectedGain (expectedGainDb)
+{
+}
+
+void
+SwitchedBeamAntennaModelTestCase::DoRun ()
+{
+  NS_LOG_FUNCTION (this << BuildNameString (m_sectors, m_mode, m_phi));
+
+  Ptr<WifiSwitchedBeamAntennaModel> a = CreateObject<WifiSwitchedBeamAntennaModel> ();
+  a->SetAttribute ("Sectors", UintegerValue (m_sectors));
+  a->SetAttribute ("InsideGain", DoubleValue (10));
+  a->SetAttribute ("OutsideGain", DoubleValue (-20));
+  a->SetAttribute ("OmniGain", DoubleValue (2));
+  a->SetOrientationModel (CreateObject<ConstantOrientationModel> ());
+
+  Ptr<ConstantPositionMobilityModel> cm1 = CreateObject<ConstantPositionMobilityModel> ();
+  cm1->SetAttribute ("Position", VectorValue (Vector (0, 0, 0)));
+  Ptr<ConstantPositionMobilityModel> cm2 = CreateObject<ConstantPositionMobilityModel> ();
+  double phi = DegreesToRadians (m_phi);
+  cm2->SetAttribute ("Position", VectorValue (Vector (std::cos (phi), std::sin (phi), 0)));
+
+  // the mode-explicit query must not switch the antenna
+  double queriedGain = a->GetGainDb (cm1, cm2, m_mode);
+  NS_TEST_EXPECT_MSG_EQ (a->GetAntennaMode (), (int)WifiSwitchedBeamAntennaModel::OMNI, "the gain query switched the antenna");
+  NS_TEST_EXPECT_MSG_EQ_TOL (queriedGain, m_expectedGain, 0.001, "wrong value of the radiation pattern");
+
+  // and must give the same gain as switching to the mode
+  a->SetAntennaMode (m_mode);
+  double actualGain = a->GetGainDb (cm1, cm2);
+  NS_TEST_EXPECT_MSG_EQ_TOL (actualGain, m_expectedGain, 0.001, "wrong value of the radiation pattern");
+
+  if (m_mode != WifiSwitchedBeamAntennaModel::OMNI && m_expectedGain > 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (a->GetNextAntennaMode (Angles (phi, 0)), m_mode, "wrong sector selected");
+    }
+}
+
+
+class CountingAntennaListener : public WifiAntennaListener
+{
+public:
+  CountingAntennaListener () : m_count (0), m_patternCount (0) {}
+  virtual void NotifyChangeAntennaMode (int mode) { m_count++; }
+  virtual void NotifyChangeGainPattern (void) { m_patternCount++; }
+  uint32_t m_count;
+  uint32_t m_patternCount;
+};
+
+class SwitchedBeamAntennaModeSwitchTestCase : public TestCase
+{
+public:
+  SwitchedBeamAntennaModeSwitchTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SwitchedBeamAntennaModeSwitchTestCase::SwitchedBeamAntennaModeSwitchTestCase ()
+  : TestCase ("repeated mode switches")
+{
+}
+
+void
+SwitchedBeamAntennaModeSwitchTestCase::DoRun ()
+{
+  Ptr<WifiSwitchedBeamAntennaModel> a = CreateObject<WifiSwitchedBeamAntennaModel> ();
+  a->SetOrientationModel (CreateObject<ConstantOrientationModel> ());
+  CountingAntennaListener listener;
+  a->RegisterListener (&listener);
+
+  a->SetAntennaMode (WifiSwitchedBeamAntennaModel::DIRECTIONAL90);
+  a->SetAntennaMode (WifiSwitchedBeamAntennaModel::DIRECTIONAL90);
+  a->SetAntennaMode (Angles (DegreesToRadians (100), 0));
+  NS_TEST_EXPECT_MSG_EQ (listener.m_count, 1, "switching to the current mode notified the listeners");
+  NS_TEST_EXPECT_MSG_EQ (a->GetNModeSwitches (), 1, "switching to the current mode was counted");
+  NS_TEST_EXPECT_MSG_EQ_TOL (a->GetOrientation ().phi, DegreesToRadians (135), 0.001, "wrong orientation of the sector");
+
+  a->SetAntennaMode (WifiSwitchedBeamAntennaModel::DIRECTIONAL180);
+  NS_TEST_EXPECT_MSG_EQ (listener.m_count, 2, "a mode change was not notified");
+  NS_TEST_EXPECT_MSG_EQ (a->GetNModeSwitches (), 2, "a mode change was not counted");
+
+  // the orientation set from outside is replaced by the one of the mode
+  a->SetOrientation (Angles (0, 0));
+  a->SetAntennaMode (WifiSwitchedBeamAntennaModel::DIRECTIONAL180);
+  NS_TEST_EXPECT_MSG_EQ (a->GetNModeSwitches (), 3, "the mode was not applied again after SetOrientation");
+  NS_TEST_EXPECT_MSG_EQ_TOL (a->GetOrientation ().phi, DegreesToRadians (225), 0.001, "wrong orientation of the sector");
+  // the sector patterns are fixed to the node
+  NS_TEST_EXPECT_MSG_EQ (listener.m_patternCount, 0, "a mode switch or orientation changed the gain pattern");
+
+  // a new number of sectors moves the current mode
+  a->SetAttribute ("Sectors", UintegerValue (6));
+  a->SetAntennaMode (WifiSwitchedBeamAntennaModel::DIRECTIONAL180);
+  NS_TEST_EXPECT_MSG_EQ (listener.m_count, 4, "the mode was not applied again after a sector change");
+  NS_TEST_EXPECT_MSG_EQ (listener.m_patternCount, 1, "a sector change was not notified as a new gain pattern");
+  NS_TEST_EXPECT_MSG_EQ_TOL (a->GetOrientation ().phi, DegreesToRadians (150), 0.001, "wrong orientation of the sector");
+
+  // a mode whose sector is removed falls back to OMNI
+  a->SetAttribute ("Sectors", UintegerValue (2));
+  NS_TEST_EXPECT_MSG_EQ (a->GetAntennaMode (), (int)WifiSwitchedBeamAntennaModel::OMNI, "the mode of a removed sector was kept");
+  a->SetAntennaMode (WifiSwitchedBeamAntennaModel::OMNI);
+  NS_TEST_EXPECT_MSG_EQ (listener.m_count, 5, "the fallback mode was not applied");
+
+  a->SetSectorGain (0, 12, -25);
+  NS_TEST_EXPECT_MSG_EQ (listener.m_patternCount, 3, "a sector gain change was not notified as a new gain pattern");
+}
+
+
+class SwitchedBeamAntennaModelTestSuite : public TestSuite
+{
+public:
+  SwitchedBeamAntennaModelTestSuite ();
+};
+
+SwitchedBeamAntennaModelTestSuite::SwitchedBeamAntennaModelTestSuite ()
+  : TestSuite ("wifi-switched-beam-antenna-model", UNIT)
+{
+  //                                                          sectors,  mode,  phi,  expectedGain
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (4,  WifiSwitchedBeamAntennaModel::OMNI,             30,    2), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (4,  WifiSwitchedBeamAntennaModel::DIRECTIONAL0,     30,   10), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (4,  WifiSwitchedBeamAntennaModel::DIRECTIONAL0,    100,  -20), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (4,  WifiSwitchedBeamAntennaModel::DIRECTIONAL90,   100,   10), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (4,  WifiSwitchedBeamAntennaModel::DIRECTIONAL180,  200,   10), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (4,  WifiSwitchedBeamAntennaModel::DIRECTIONAL270,  -30,   10), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (4,  WifiSwitchedBeamAntennaModel::DIRECTIONAL270,   30,  -20), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (6,  1,                                               50,   10), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (6,  1,                                               70,  -20), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (6,  2,                                               70,   10), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (8,  8,                                              -10,   10), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (12, 5,                                              135,   10), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModelTestCase (12, 5,                                              155,  -20), TestCase::QUICK);
+  AddTestCase (new SwitchedBeamAntennaModeSwitchTestCase (), TestCase::QUICK);
+};
+
+static SwitchedBeamAntennaModelTestSuite staticSwitchedBeamAntennaModelTestSuiteInstance;